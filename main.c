@@ -2,28 +2,69 @@
 
 // Prototipos das funcoes de controle do Integrador
 void exibir_cabecalho();
-void portal_coordenacao(Professor **lp, Turma **lt, FilaEspera *f);
+void portal_coordenacao(Professor **lp, Turma **lt, FilaEspera *f, Pilha *seguranca, const char *campus, RedeEscolar *rede);
 void portal_docente(Turma *lt, Pilha *seguranca, Professor *lp);
 void encerrar_sistema(Turma *lt, Professor *lp, FilaEspera *f);
-void portal_aluno(Turma *lt);
+void portal_aluno(Turma *lt, const char *campus);
+void portal_rede(RedeEscolar *rede, Campus **atual);
+void portal_fila(FilaEspera *f);
+int portal_replica(const char *nome);
 void limpar_buffer();
 
-int main() {
-	// Instanciacao dos Descritores de Estruturas
-	Professor *lista_professores = NULL;
-	Turma *lista_turmas = NULL;
-	FilaEspera *espera = criar_fila();
-	Pilha *seguranca = criarPilha();
+int main(int argc, char **argv) {
+	// Linha de comando: --publicar [nome] mantem a replica de leitura em memoria
+	// compartilhada; --leitor [nome] abre so o portal de consulta sobre ela
+	const char *replica_publicar = NULL;
+	for (int i = 1; i < argc; i++) {
+		const char *nome = (i + 1 < argc && argv[i + 1][0] == '/') ? argv[i + 1] : REPLICA_NOME_PADRAO;
+		if (strcmp(argv[i], "--leitor") == 0) return portal_replica(nome);
+		if (strcmp(argv[i], "--publicar") == 0) replica_publicar = nome;
+	}
+
+	// Instanciacao dos Descritores de Estruturas: a rede comeca com o campus sede
+	RedeEscolar rede = {NULL, 0, 0};
+	Campus *atual = criar_campus("Sede");
+	if (!adicionar_campus(&rede, atual)) return 1;
+
+	// Fluxo de eventos para consumidores externos (opcional)
+	const char *arquivo_eventos = getenv("KOLPING_EVENTOS");
+	if (arquivo_eventos && iniciar_eventos(arquivo_eventos))
+		printf("[SISTEMA] Eventos de alteracao gravados em %s\n", arquivo_eventos);
+
+	// Rastreamento de desempenho (JSON de trace events, gravado na saida)
+	const char *arquivo_rastreio = getenv("KOLPING_RASTREIO");
+	if (arquivo_rastreio && iniciar_rastreio(arquivo_rastreio))
+		printf("[SISTEMA] Rastreamento ativo: %s (chrome://tracing ou ui.perfetto.dev)\n", arquivo_rastreio);
+
+	PublicadorReplica replica;
+	Campus *campus_publicado = NULL;
+	if (replica_publicar) {
+		if (iniciar_publicacao(&replica, replica_publicar))
+			printf("[SISTEMA] Replica de leitura publicada em %s (consulta: --leitor %s)\n",
+			       replica_publicar, replica_publicar);
+		else
+			printf("[AVISO] Nao foi possivel criar a replica '%s'.\n", replica_publicar);
+	} else {
+		memset(&replica, 0, sizeof(replica));
+	}
 
 	int opcao;
 
 	do {
+		// Republica a replica se algo mudou (ou se o campus ativo trocou)
+		if (replica.base) {
+			publicar_replica(&replica, atual->lista_turmas, atual->nome, atual != campus_publicado);
+			campus_publicado = atual;
+		}
 		exibir_cabecalho();
+		printf("Campus: %s\n", atual->nome);
 		printf("1. Portal da Coordenacao (Matricula)\n");
 		printf("2. Portal do Docente (Notas & Desfazer)\n");
 		printf("3. Portal do Aluno (Boletim)\n");
-		printf("4. Visualizar Fila de Espera\n");
+		printf("4. Fila de Espera (Prioridades & Desistencias)\n");
 		printf("5. Remover Aluno (Abrir Vaga)\n");
+		printf("6. Buscar Aluno/Professor por Nome\n");
+		printf("7. Rede de Campi (Trocar Campus & Consultas)\n");
 		printf("0. Sair e Liberar Memoria\n");
 		printf("----------------------------\n");
 		printf("Escolha: ");
@@ -37,19 +78,19 @@ int main() {
 		switch(opcao) {
 		case 1:
 			entrar_menu(1);
-			portal_coordenacao(&lista_professores, &lista_turmas, espera);
+			portal_coordenacao(&atual->lista_professores, &atual->lista_turmas, atual->espera, atual->seguranca, atual->nome, &rede);
 			break;
 		case 2:
 			entrar_menu(2);
-			portal_docente(lista_turmas, seguranca, lista_professores);
+			portal_docente(atual->lista_turmas, atual->seguranca, atual->lista_professores);
 			break;
 		case 3:
 			entrar_menu(3);
-			portal_aluno(lista_turmas);
+			portal_aluno(atual->lista_turmas, atual->nome);
 			break;
 		case 4:
 			entrar_menu(4);
-			exibir_fila(espera);
+			portal_fila(atual->espera);
 			break;
 		case 5: {
 			entrar_menu(5);
@@ -58,13 +99,40 @@ int main() {
 			scanf("%s", mat_aux);
 			limpar_buffer();
 
-			remover_aluno_turma(lista_turmas, mat_aux, espera);
+			remover_aluno_turma(atual->lista_turmas, mat_aux, atual->espera);
+			break;
+		}
+		case 6: {
+			entrar_menu(6);
+			char prefixo[100];
+			printf("Nome (ou inicio do nome): ");
+			scanf(" %99[^\n]", prefixo);
+			limpar_buffer();
+
+			exibir_busca_nome(atual, prefixo);
 			break;
 		}
+		case 7:
+			entrar_menu(7);
+			portal_rede(&rede, &atual);
+			break;
 		case 0:
 			printf("\nEncerrando Sistema Kolping");
-			encerrar_sistema(lista_turmas, lista_professores, espera);
-			free(seguranca);
+			encerrar_exportacoes(); // Conclui relatorios pendentes antes de liberar as turmas
+			encerrar_publicacao(&replica);
+			encerrar_eventos();
+			for (int i = 0; i < rede.qtd; i++) {
+				Campus *c = rede.campi[i];
+				encerrar_sistema(c->lista_turmas, c->lista_professores, c->espera);
+				limpar_pilha(c->seguranca);
+				free(c->seguranca);
+				free(c);
+			}
+			free(rede.campi);
+			liberar_indice_nomes();
+			liberar_departamentos();
+			fechar_arquivos_abertos();
+			encerrar_rastreio();
 			printf("\n[STATUS] Memoria Heap limpa.\n");
 			break;
 		}
@@ -81,11 +149,19 @@ void exibir_cabecalho() {
 	printf("\n========================================\n");
 }
 
-void portal_coordenacao(Professor **lp, Turma **lt, FilaEspera *f) {
+void portal_coordenacao(Professor **lp, Turma **lt, FilaEspera *f, Pilha *seguranca, const char *campus, RedeEscolar *rede) {
 	int sub_op;
 	printf("\n PORTAL DA COORDENACAO ");
 	printf("\n1. Matricular Aluno (Lista/Fila)");
 	printf("\n2. Cadastrar Professor (Lista Global)");
+	printf("\n3. Promocao de Fim de Ano (Todas as Turmas)");
+	printf("\n4. Estatisticas por Serie e da Escola");
+	printf("\n5. Importar Arquivo (Matriculas e Notas)");
+	printf("\n6. Arquivar Ano Letivo Encerrado");
+	printf("\n7. Exportar Notas da Escola (CSV, em segundo plano)");
+	printf("\n8. Acompanhar Exportacoes");
+	printf("\n9. Regras de Avaliacao (Serie/Turma)");
+	printf("\n10. Alocar Professores Automaticamente (Todas as Turmas)");
 	printf("\n0. Voltar");
 	printf("\nEscolha: ");
 
@@ -106,53 +182,196 @@ void portal_coordenacao(Professor **lp, Turma **lt, FilaEspera *f) {
 		scanf("%s", mat);
 		printf("Serie (1-12): ");
 		scanf("%d", &serie);
+		printf("Prioridade na fila (1-Irmao 2-Filho de funcionario 3-Transferencia 4-Geral): ");
+		int prioridade;
+		if (scanf("%d", &prioridade) != 1 || prioridade < 1 || prioridade > PRIORIDADE_CLASSES)
+			prioridade = PRIORIDADE_GERAL + 1;
 		limpar_buffer();
+		if (serie < 1 || serie > 12) {
+			printf("[ERRO] Serie invalida: %d. Deve ser entre 1 e 12.\n", serie);
+			return;
+		}
 
 		Aluno *novo = matricular_aluno(mat, nome, serie);
-
-		Turma *turma_destino = NULL;
-		Turma *busca = *lt;
-		while (busca != NULL) {
-			if (busca->serie == serie) {
-				turma_destino = busca;
-				break;
-			}
-			busca = busca->proximo_turma;
+		if (!novo) {
+			printf("[ERRO] Memoria insuficiente para a matricula.\n");
+			return;
 		}
+		novo->prioridade = (PrioridadeFila) (prioridade - 1);
+
+		Turma *turma_destino = buscar_turma_serie(*lt, serie);
 
 		// Se nao encontrou, cria uma nova turma para esta serie
 		if (turma_destino == NULL) {
-			char codigo_turma[10];
-			if (serie == 10)
-				sprintf(codigo_turma, "1EM-A");
-			else if (serie == 11)
-				sprintf(codigo_turma, "2EM-A");
-			else if (serie == 12)
-				sprintf(codigo_turma, "3EM-A");
-			else
-				sprintf(codigo_turma, "%dANO-A", serie);
-			turma_destino = criar_turma(codigo_turma, serie, 5);
-			inserir_turma_lista(lt, turma_destino);
-			printf("[SISTEMA] Nova turma criada: %s\n", codigo_turma);
+			turma_destino = criar_turma_serie(lt, serie);
+			printf("[SISTEMA] Nova turma criada: %s\n", turma_destino->codigo);
 		}
 
 		processar_matricula_turma(turma_destino, novo, f);
 
 	} else if (sub_op == 2) {
 		char id[15], nome[100], depto[50];
+		int carga;
 
 		printf("\n--- CADASTRO DE PROFESSOR ---");
 		printf("\nID (Ex: KOLP-01): ");
 		scanf("%s", id);
 		printf("Nome: ");
 		scanf(" %[^\n]", nome);
-		printf("Departamento: ");
+		printf("Departamento(s) (ex: Exatas ou Humanas/Filosofia): ");
 		scanf(" %[^\n]", depto);
+		printf("Carga maxima (turma-disciplinas, 0 = padrao %d): ", CARGA_PADRAO);
+		if (scanf("%d", &carga) != 1 || carga < 0) carga = 0;
 		limpar_buffer();
 
 		Professor *novo_p = criar_professor(id, nome, depto);
+		if (novo_p && carga > 0) novo_p->carga_maxima = carga;
 		inserir_professor_global(lp, novo_p);
 		printf("\n[SUCESSO] Professor %s cadastrado na Lista Global!\n", nome);
+
+	} else if (sub_op == 3) {
+		char confirma;
+		printf("\n--- PROMOCAO DE FIM DE ANO ---");
+		printf("\nTodas as notas serao zeradas e os vinculos de professores desfeitos.");
+		printf("\nPara manter os boletins deste ano consultaveis, arquive-o antes (opcao 6).");
+		printf("\nConfirmar (s/n): ");
+		scanf(" %c", &confirma);
+		limpar_buffer();
+		if (confirma != 's' && confirma != 'S') return;
+
+		ResumoPromocao res;
+		promover_ano_letivo(lt, f, seguranca, &res);
+		printf("\n[SUCESSO] Ano letivo encerrado.\n");
+		printf("Aprovados: %d | Retidos: %d | Formandos: %d | Na fila: %d | Turmas criadas: %d\n",
+		       res.aprovados, res.retidos, res.formandos, res.em_fila, res.turmas_criadas);
+		if (res.serie_invalida)
+			printf("[AVISO] %d aluno(s) com serie fora de 1-12 ficaram sem promocao.\n", res.serie_invalida);
+		if (res.acima_limite)
+			printf("[AVISO] %d aluno(s) sem vaga nem fila de espera excedem o limite da turma.\n", res.acima_limite);
+
+	} else if (sub_op == 4) {
+		exibir_estatisticas_escola(*lt);
+
+	} else if (sub_op == 5) {
+		char caminho[256];
+		printf("\n--- IMPORTACAO EM LOTE ---");
+		printf("\nFormato: A;matricula;nome;serie  |  N;matricula;disciplina;unidade;prova;nota");
+		printf("\nArquivo: ");
+		scanf(" %255[^\n]", caminho);
+		limpar_buffer();
+
+		ResumoImportacao res;
+		if (!importar_arquivo(caminho, lt, f, &res)) {
+			printf("[ERRO] Nao foi possivel abrir '%s'.\n", caminho);
+			return;
+		}
+		printf("\n[SUCESSO] %ld linha(s) lidas em %.3fs (%d thread(s)), aplicadas em %.3fs.\n",
+		       res.linhas, res.segundos_leitura, res.threads, res.segundos_aplicacao);
+		printf("Matriculados: %d | Na fila: %d | Notas: %d | Duplicados: %d | Erros: %d\n",
+		       res.matriculados, res.em_fila, res.notas, res.duplicados, res.erros);
+		for (int i = 0; i < res.qtd_erros; i++)
+			printf("  Linha %ld: %s\n", res.primeiros_erros[i].linha, res.primeiros_erros[i].motivo);
+
+	} else if (sub_op == 6) {
+		int ano;
+		char caminho[128];
+		printf("\n--- ARQUIVAR ANO LETIVO ---");
+		printf("\nAno letivo (ex: 2025): ");
+		if (scanf("%d", &ano) != 1 || ano < 1900 || ano > 9999) {
+			limpar_buffer();
+			printf("[ERRO] Ano invalido.\n");
+			return;
+		}
+		limpar_buffer();
+
+		caminho_arquivo_ano(caminho, sizeof(caminho), campus, ano);
+		ResumoArquivo res;
+		if (!arquivar_ano_letivo(*lt, ano, caminho, &res)) {
+			printf("[ERRO] Nao foi possivel gravar '%s'.\n", caminho);
+			return;
+		}
+		printf("\n[SUCESSO] %d aluno(s) arquivados em '%s' (%d bloco(s)).\n", res.alunos, caminho, res.blocos);
+		printf("Tamanho: %ld bytes (em memoria: ~%ld bytes).\n", res.bytes_arquivo, res.bytes_memoria);
+
+	} else if (sub_op == 7) {
+		char caminho[256];
+		printf("\nArquivo de saida (ex: notas.csv): ");
+		scanf(" %255[^\n]", caminho);
+		limpar_buffer();
+
+		int id = agendar_exportacao_csv(*lt, caminho);
+		if (id) printf("[SISTEMA] Exportacao #%d enviada. Acompanhe pela opcao 8.\n", id);
+		else printf("[ERRO] Nao foi possivel agendar a exportacao.\n");
+
+	} else if (sub_op == 8) {
+		exibir_tarefas_exportacao();
+
+	} else if (sub_op == 9) {
+		int alvo, serie = 0;
+		char codigo[10] = "", regra[256], erro[128];
+		exibir_planos(*lt);
+		printf("\nAplicar a: 1. Serie (todos os campi)  2. Turma: ");
+		if (scanf("%d", &alvo) != 1 || (alvo != 1 && alvo != 2)) {
+			limpar_buffer();
+			printf("[ERRO] Opcao invalida.\n");
+			return;
+		}
+		if (alvo == 1) {
+			printf("Serie (1-12): ");
+			if (scanf("%d", &serie) != 1 || serie < 1 || serie > 12) {
+				limpar_buffer();
+				printf("[ERRO] Serie invalida.\n");
+				return;
+			}
+		} else {
+			printf("Codigo da turma: ");
+			scanf("%9s", codigo);
+		}
+		limpar_buffer();
+		Turma *t = NULL;
+		if (alvo == 2) {
+			for (t = *lt; t && strcmp(t->codigo, codigo) != 0; t = t->proximo_turma);
+			if (!t) {
+				printf("[ERRO] Turma '%s' nao encontrada.\n", codigo);
+				return;
+			}
+		}
+		printf("Regra (ex: unidades=2,2,3,3; provas=1,1; recuperacao=menor; aprovacao=6.0)\n");
+		printf("Vazio = voltar ao padrao: ");
+		if (!fgets(regra, sizeof(regra), stdin)) regra[0] = '\0';
+		regra[strcspn(regra, "\r\n")] = '\0';
+
+		PlanoAvaliacao plano;
+		const PlanoAvaliacao *novo = NULL;
+		if (regra[0]) {
+			if (!compilar_plano(regra, &plano, erro, sizeof(erro))) {
+				printf("[ERRO] Regra invalida: %s\n", erro);
+				return;
+			}
+			novo = &plano;
+		}
+		int qtd = (alvo == 1) ? definir_plano_serie_rede(rede, serie, novo) : definir_plano_turma(t, novo);
+		printf("[SUCESSO] Regra %s. %d aluno(s) com medias recalculadas.\n",
+		       novo ? novo->regra : "removida", qtd);
+
+	} else if (sub_op == 10) {
+		char confirma;
+		Alocacao aloc;
+		if (!calcular_alocacao(*lp, *lt, &aloc)) {
+			printf("[ERRO] Memoria insuficiente para a alocacao.\n");
+			return;
+		}
+		exibir_alocacao(&aloc);
+		if (aloc.qtd_encargos == 0) {
+			liberar_alocacao(&aloc);
+			return;
+		}
+		printf("\nAplicar esta alocacao a todas as turmas (s/n): ");
+		scanf(" %c", &confirma);
+		limpar_buffer();
+		if (confirma == 's' || confirma == 'S')
+			printf("[SUCESSO] Alocacao aplicada: %d encargo(s) mudaram de professor.\n", aplicar_alocacao(&aloc));
+		liberar_alocacao(&aloc);
 	}
 }
 
@@ -163,6 +382,7 @@ void encerrar_sistema(Turma *lt, Professor *lp, FilaEspera *f) {
 	while (lp) {
 		Professor *temp = lp;
 		lp = lp->proximo;
+		free(temp->cargas);
 		free(temp);
 	}
 
@@ -170,28 +390,49 @@ void encerrar_sistema(Turma *lt, Professor *lp, FilaEspera *f) {
 	while (f && f->quantidade > 0) {
 		desenfileirar(f);
 	}
-	if(f) free(f);
+	liberar_fila(f);
 
 	// 3. Limpa Turmas
 	while (lt) {
 		Turma *temp = lt;
 		lt = lt->proximo_turma;
+		texto_liberar(&temp->cache_relatorio.texto);
+		liberar_historico(temp->historico);
+		free(temp->plano);
 		free(temp);
 	}
+	liberar_planos();
 
 	printf("\nMemoria liberada com sucesso. Ate logo!\n");
 }
 
-void portal_aluno(Turma *lt) {
-	if (!lt) {
-		printf("\nErro: Nenhuma turma cadastrada.\n");
-		return;
-	}
+void portal_aluno(Turma *lt, const char *campus) {
 	char mat[20];
+	int ano = 0;
 	printf("\n--- PORTAL DO ALUNO ---\nMatricula: ");
 	scanf("%s", mat);
+	printf("Ano letivo (0 = ano atual): ");
+	if (scanf("%d", &ano) != 1) ano = 0;
 	limpar_buffer();
 
+	// Anos encerrados: consulta o arquivo do ano, carregando so o bloco necessario
+	if (ano != 0) {
+		ArquivoAno *arq = arquivo_do_ano(campus, ano);
+		if (!arq) {
+			printf("Ano %d nao arquivado.\n", ano);
+			return;
+		}
+		const AlunoArquivado *r = consultar_arquivo(arq, mat);
+		if (r) exibir_boletim_arquivado(r, ano);
+		else printf("Aluno nao encontrado no arquivo de %d.\n", ano);
+		return;
+	}
+
+	if (!lt) {
+		printf("\nErro: Nenhuma turma cadastrada.\n");
+		return;
+	}
+
 	// Percorre todas as turmas ate encontrar o aluno
 	Turma *t = lt;
 	while (t != NULL) {
@@ -266,6 +507,13 @@ void portal_docente(Turma *lt, Pilha *seguranca, Professor *lp) {
 	printf("5. Desfazer Ultima Alteracao de Nota\n");
 	printf("6. Gerar Relatorio Final (Fechamento)\n");
 	printf("7. Vincular Professor a Disciplina\n");
+	printf("8. Consultar Notas em uma Data (Historico)\n");
+	printf("9. Estatisticas da Turma\n");
+	printf("10. Diario de Classe (Ordem Alfabetica)\n");
+	printf("11. Gerar Relatorio Final em Arquivo (Segundo Plano)\n");
+	printf("12. Registrar Chamada (Turma Inteira)\n");
+	printf("13. Alunos em Risco por Faltas\n");
+	printf("14. Lancar Recuperacao\n");
 	printf("0. Voltar\n");
 	printf("----------------------------------------\n");
 	printf("Escolha: ");
@@ -386,22 +634,309 @@ void portal_docente(Turma *lt, Pilha *seguranca, Professor *lp) {
 			return;
 		}
 
-		int contador = 0;
+		int contador = 0, falhas = 0;
 		Aluno *atual = turma_selecionada->lista_alunos;
 		while (atual != NULL) {
-			atribuir_professor(atual, materia, p);
-			contador++;
+			if (atribuir_professor(atual, materia, p)) contador++;
+			else falhas++;
 			atual = atual->proximo;
 		}
 
 		printf("[SUCESSO] Professor %s vinculado a '%s' para %d aluno(s) da turma %s.\n",
 		       p->nome, materia, contador, turma_selecionada->codigo);
+		if (falhas)
+			printf("[AVISO] %d aluno(s) sem o vinculo (disciplina fora da grade ou memoria insuficiente).\n", falhas);
+
+	} else if (sub_op == 8) {
+		char mat[20], data[20];
+		printf("\n--- HISTORICO DE NOTAS ---\n");
+		printf("Matricula: ");
+		scanf("%s", mat);
+		printf("Data (dd/mm/aaaa ou dd/mm/aaaa-hh:mm): ");
+		scanf("%19s", data);
+		limpar_buffer();
+
+		struct tm tm_data;
+		memset(&tm_data, 0, sizeof(tm_data));
+		int hora = 23, minuto = 59;
+		int lidos = sscanf(data, "%d/%d/%d-%d:%d", &tm_data.tm_mday, &tm_data.tm_mon,
+		                   &tm_data.tm_year, &hora, &minuto);
+		if (lidos != 3 && lidos != 5) {
+			printf("[ERRO] Data invalida.\n");
+			return;
+		}
+		tm_data.tm_mon -= 1;
+		tm_data.tm_year -= 1900;
+		tm_data.tm_hour = hora;
+		tm_data.tm_min = minuto;
+		tm_data.tm_sec = (lidos == 3) ? 59 : 0; // So a data: considera o dia inteiro
+		tm_data.tm_isdst = -1;
+		consultar_notas_aluno_em(turma_selecionada, mat, mktime(&tm_data));
+
+	} else if (sub_op == 9) {
+		EstatisticasGrupo *est = (EstatisticasGrupo*) malloc(sizeof(EstatisticasGrupo));
+		if (!est) return;
+		coletar_estatisticas_turma(turma_selecionada, est);
+		exibir_estatisticas(est);
+		free(est);
+
+	} else if (sub_op == 10) {
+		int pagina;
+		printf("Pagina (%d alunos por pagina): ", DIARIO_POR_PAGINA);
+		if (scanf("%d", &pagina) != 1) pagina = 1;
+		limpar_buffer();
+		exibir_pagina_diario(turma_selecionada, pagina);
+
+	} else if (sub_op == 11) {
+		char caminho[256];
+		printf("Arquivo de saida (ex: fechamento.txt): ");
+		scanf(" %255[^\n]", caminho);
+		limpar_buffer();
+
+		int id = agendar_relatorio(turma_selecionada, caminho);
+		if (id) printf("[SISTEMA] Relatorio #%d enviado. Acompanhe pela Coordenacao (opcao 8).\n", id);
+		else printf("[ERRO] Nao foi possivel agendar o relatorio.\n");
+
+	} else if (sub_op == 12) {
+		char materia[50], linha[4096];
+		int dia, qtd_ausentes = 0, excedeu = 0;
+		printf("\n--- CHAMADA ---\n");
+		if (turma_selecionada->lista_alunos)
+			listar_disciplinas_aluno(turma_selecionada->lista_alunos);
+		printf("Disciplina: ");
+		scanf(" %49[^\n]", materia);
+		printf("Dia letivo (1-%d): ", DIAS_LETIVOS);
+		if (scanf("%d", &dia) != 1) dia = 0;
+		limpar_buffer();
+		printf("Matriculas ausentes (separadas por espaco, vazio = todos presentes): ");
+		if (!fgets(linha, sizeof(linha), stdin)) linha[0] = '\0';
+
+		if (!strchr(linha, '\n') && !feof(stdin)) {
+			printf("[ERRO] Lista de ausentes longa demais. Chamada nao registrada.\n");
+			limpar_buffer();
+			return;
+		}
+
+		// Nunca ha mais ausentes que alunos matriculados
+		char **ausentes = (char**) malloc((turma_selecionada->qtd_atual + 1) * sizeof(char*));
+		if (!ausentes) return;
+		for (char *tok = strtok(linha, " ,;\n"); tok; tok = strtok(NULL, " ,;\n")) {
+			if (qtd_ausentes == turma_selecionada->qtd_atual) { excedeu = 1; break; }
+			ausentes[qtd_ausentes++] = tok;
+		}
+		if (excedeu) {
+			printf("[ERRO] Mais ausentes que os %d aluno(s) da turma. Chamada nao registrada.\n",
+			       turma_selecionada->qtd_atual);
+			free(ausentes);
+			return;
+		}
+
+		int sem_aluno = 0;
+		int presentes = registrar_chamada(turma_selecionada, materia, dia, ausentes, qtd_ausentes, &sem_aluno);
+		if (presentes < 0)
+			printf("[ERRO] Dia ou disciplina invalidos.\n");
+		else {
+			printf("[SUCESSO] Chamada do dia %d registrada: %d presente(s), %d ausente(s).\n",
+			       dia, presentes, turma_selecionada->qtd_atual - presentes);
+			if (sem_aluno)
+				printf("[AVISO] %d matricula(s) informada(s) nao pertencem a turma (ignoradas).\n", sem_aluno);
+		}
+		free(ausentes);
+
+	} else if (sub_op == 13) {
+		exibir_alunos_em_risco(turma_selecionada);
+
+	} else if (sub_op == 14) {
+		char mat[20], materia[50];
+		float nota;
+		printf("\n--- RECUPERACAO ---\n");
+		printf("Matricula: ");
+		scanf("%19s", mat);
+		limpar_buffer();
+		Aluno *a = buscar_aluno(turma_selecionada->lista_alunos, mat);
+		if (!a) {
+			printf("[ERRO] Aluno nao encontrado.\n");
+			return;
+		}
+		listar_disciplinas_aluno(a);
+		printf("Disciplina: ");
+		scanf(" %49[^\n]", materia);
+		printf("Nota da recuperacao (0-10, 0 = anular): ");
+		if (scanf("%f", &nota) != 1) nota = -1;
+		limpar_buffer();
+		lancar_recuperacao(turma_selecionada->lista_alunos, mat, materia, nota);
 
 	} else if (sub_op == 0) {
 		voltar_menu();
 	}
 }
 
+void portal_fila(FilaEspera *f) {
+	int sub_op;
+	exibir_fila(f);
+	printf("\n1. Alterar Prioridade de um Candidato");
+	printf("\n2. Registrar Desistencia");
+	printf("\n0. Voltar");
+	printf("\nEscolha: ");
+
+	if (scanf("%d", &sub_op) != 1) {
+		limpar_buffer();
+		return;
+	}
+	limpar_buffer();
+
+	if (sub_op == 1) {
+		char mat[20];
+		int prioridade;
+		printf("Matricula: ");
+		scanf("%19s", mat);
+		printf("Nova prioridade (1-Irmao 2-Filho de funcionario 3-Transferencia 4-Geral): ");
+		if (scanf("%d", &prioridade) != 1) prioridade = 0;
+		limpar_buffer();
+
+		if (alterar_prioridade_fila(f, mat, (PrioridadeFila) (prioridade - 1)))
+			printf("[SUCESSO] Prioridade de %s atualizada.\n", mat);
+		else
+			printf("[ERRO] Candidato nao encontrado ou prioridade invalida.\n");
+
+	} else if (sub_op == 2) {
+		char mat[20];
+		printf("Matricula: ");
+		scanf("%19s", mat);
+		limpar_buffer();
+
+		Aluno *a = retirar_fila(f, mat);
+		if (!a) {
+			printf("[ERRO] Candidato nao encontrado na fila.\n");
+			return;
+		}
+		printf("[SUCESSO] %s retirado da fila de espera.\n", a->nome);
+		deletar_aluno(a);
+	}
+}
+
+void portal_rede(RedeEscolar *rede, Campus **atual) {
+	int sub_op;
+	printf("\n REDE DE CAMPI (%d campus/campi) ", rede->qtd);
+	for (int i = 0; i < rede->qtd; i++)
+		printf("\n   - %s%s", rede->campi[i]->nome, rede->campi[i] == *atual ? " (atual)" : "");
+	printf("\n1. Trocar de Campus");
+	printf("\n2. Cadastrar Novo Campus");
+	printf("\n3. Taxa de Aprovacao da Rede");
+	printf("\n4. Localizar Aluno em Todos os Campi");
+	printf("\n5. Estatisticas de uma Serie na Rede");
+	printf("\n0. Voltar");
+	printf("\nEscolha: ");
+
+	if (scanf("%d", &sub_op) != 1) {
+		limpar_buffer();
+		return;
+	}
+	limpar_buffer();
+
+	if (sub_op == 1 || sub_op == 2) {
+		char nome[50];
+		printf("Nome do campus: ");
+		scanf(" %49[^\n]", nome);
+		limpar_buffer();
+
+		Campus *c = buscar_campus(rede, nome);
+		if (sub_op == 1) {
+			if (!c) { printf("[ERRO] Campus nao encontrado.\n"); return; }
+			*atual = c;
+			printf("[SUCESSO] Campus atual: %s\n", c->nome);
+		} else {
+			if (c) { printf("[ERRO] Ja existe um campus com esse nome.\n"); return; }
+			c = criar_campus(nome);
+			if (!adicionar_campus(rede, c)) { printf("[ERRO] Memoria insuficiente.\n"); return; }
+			*atual = c;
+			printf("[SUCESSO] Campus %s cadastrado e selecionado.\n", c->nome);
+		}
+
+	} else if (sub_op == 3) {
+		exibir_aprovacao_rede(rede);
+
+	} else if (sub_op == 4) {
+		char mat[20];
+		printf("Matricula: ");
+		scanf("%19s", mat);
+		limpar_buffer();
+
+		Aluno *a = NULL;
+		Turma *t = NULL;
+		Campus *c = localizar_aluno_rede(rede, mat, &a, &t);
+		if (!c) { printf("Aluno nao encontrado em nenhum campus.\n"); return; }
+		printf("[INFO] %s (%s) - Campus %s | %s\n", a->nome, a->matricula, c->nome,
+		       t ? t->codigo : "fila de espera");
+		exibir_boletim(a);
+
+	} else if (sub_op == 5) {
+		int serie;
+		printf("Serie (1-12): ");
+		if (scanf("%d", &serie) != 1 || serie < 1 || serie > 12) {
+			limpar_buffer();
+			printf("[ERRO] Serie invalida.\n");
+			return;
+		}
+		limpar_buffer();
+		exibir_estatisticas_serie_rede(rede, serie);
+	}
+}
+
+/* Processo de consulta: atende boletins e relatorios a partir da replica
+   publicada por outro processo, sem tocar no estado dele. */
+int portal_replica(const char *nome) {
+	LeitorReplica leitor;
+	if (!abrir_replica(&leitor, nome)) {
+		printf("[ERRO] Replica '%s' indisponivel. Inicie o sistema com --publicar %s.\n", nome, nome);
+		return 1;
+	}
+	int sub_op;
+	do {
+		exibir_cabecalho();
+		printf("PORTAL DE CONSULTA (REPLICA %s)\n", nome);
+		printf("1. Boletim por Matricula\n");
+		printf("2. Relatorio de Fechamento de uma Turma\n");
+		printf("3. Listar Turmas\n");
+		printf("4. Estado da Replica\n");
+		printf("0. Sair\n");
+		printf("Escolha: ");
+		if (scanf("%d", &sub_op) != 1) {
+			limpar_buffer();
+			continue;
+		}
+		limpar_buffer();
+
+		if (sub_op == 1) {
+			char mat[20];
+			printf("Matricula: ");
+			scanf("%19s", mat);
+			limpar_buffer();
+			int r = replica_exibir_boletim(&leitor, mat);
+			if (r == 0) printf("[ERRO] Aluno '%s' nao encontrado na replica.\n", mat);
+			else if (r < 0) printf("[ERRO] Replica indisponivel no momento.\n");
+
+		} else if (sub_op == 2) {
+			char codigo[10];
+			printf("Codigo da turma: ");
+			scanf("%9s", codigo);
+			limpar_buffer();
+			int r = replica_exibir_turmas(&leitor, codigo);
+			if (r == 0) printf("[ERRO] Turma '%s' nao encontrada na replica.\n", codigo);
+			else if (r < 0) printf("[ERRO] Replica indisponivel no momento.\n");
+
+		} else if (sub_op == 3) {
+			printf("\n");
+			if (replica_exibir_turmas(&leitor, NULL) < 0) printf("[ERRO] Replica indisponivel no momento.\n");
+
+		} else if (sub_op == 4) {
+			replica_exibir_estado(&leitor);
+		}
+	} while (sub_op != 0);
+	fechar_replica(&leitor);
+	return 0;
+}
+
 void limpar_buffer() {
 	int c;
 	while ((c = getchar()) != '\n' && c != EOF);
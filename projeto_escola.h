@@ -1,24 +1,107 @@
+// mmap/madvise, shm_open e clock_gettime também sob -std=c11 (antes de qualquer include)
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 /* ==========================================================================
    1. ESTRUTURAS DE DADOS (MODELAGEM HIERÁRQUICA)
    ========================================================================== */
 
+// Texto renderizado em memória (buffer dinâmico usado pelos caches de relatório)
+typedef struct {
+    char  *dados;
+    size_t tamanho;
+    size_t capacidade;
+} Texto;
+
+// Texto + versão do dono no momento em que foi renderizado (0 = cache vazio)
+typedef struct {
+    Texto texto;
+    unsigned int versao;
+} CacheTexto;
+
+// Nota em ponto fixo: centésimos de ponto (0 a 1000 representa 0.00 a 10.00)
+typedef uint16_t Nota;
+
+#define NOTA_ESCALA       100   // 1 ponto = 100 centésimos
+#define NOTA_MAXIMA       1000  // 10.00
+#define MEDIA_APROVACAO   500   // 5.00, comparado em inteiros (sem ruído de float)
+
+// Frequência: um bit por dia letivo, em palavras de 64 bits
+#define DIAS_LETIVOS       200   // Mínimo anual da LDB
+#define PRESENCA_PALAVRAS  ((DIAS_LETIVOS + 63) / 64)
+#define FREQUENCIA_MINIMA  750   // 75.0% (milésimos) exigidos para aprovação
+#define FREQUENCIA_ALERTA  800   // Abaixo disso o aluno entra na lista de risco
+
 // Notas organizadas por Unidade (Bimestre)
+// A média da unidade não é armazenada: é derivada de prova1/prova2 sob demanda.
 typedef struct {
-    float prova1;
-    float prova2;
-    float media_unidade;
+    Nota prova1;
+    Nota prova2;
 } Unidade;
 
+// Regra de avaliação compilada (ver seção 2.2): pesos inteiros e divisores
+// pré-calculados, para que a média anual seja uma soma ponderada com um
+// único arredondamento, sem reinterpretar a regra a cada nota.
+typedef struct PlanoAvaliacao {
+    uint16_t peso_prova[2];     // Peso de P1 e P2 dentro da unidade
+    uint16_t peso_unidade[4];   // Peso de cada bimestre na média anual
+    uint16_t soma_provas;       // peso_prova[0] + peso_prova[1]
+    uint32_t divisor;           // soma_provas * soma dos pesos das unidades
+    uint8_t  recuperacao;       // 1 = a recuperação substitui a menor unidade (se maior)
+    Nota     aprovacao;         // Média mínima para aprovação (centésimos)
+    char     regra[128];        // Forma canônica da regra, para exibição
+} PlanoAvaliacao;
+
+#define CARGA_PADRAO  10        // Turma-disciplinas por professor, se não informado
+
+// Totais de um departamento, mantidos junto com os dos professores (ver seção 3)
+typedef struct Departamento {
+    char nome[50];             // 1ª área do campo 'departamento' dos professores
+    int professores;
+    int encargos;              // Pares (turma, disciplina) atendidos pelos professores
+    long vinculos;             // Disciplinas de alunos vinculadas
+    long soma_medias;          // Soma das media_final dessas disciplinas (centésimos)
+    struct Departamento *proximo;
+} Departamento;
+
+// Quantos alunos de uma turma o professor atende numa disciplina
+typedef struct CargaTurma {
+    struct Turma *turma;
+    int disciplina;            // Índice na grade da série
+    int alunos;
+} CargaTurma;
+
 // Entidade Professor: Nó da Lista Encadeada Global de Docentes
 typedef struct Professor {
     char id[15];               // Identificador Único (ex: KOLP-01)
     char nome[100];
-    char departamento[50];     // Área de atuação (ex: Exatas, Humanas)
+    char departamento[50];     // Área(s) de atuação (ex: "Exatas", "Humanas/Filosofia")
     char email_funcional[150]; // Gerado automaticamente: nome.id@docente.kolping.edu.br
+    int carga_maxima;          // Máximo de turma-disciplinas na alocação automática
+    Departamento *depto;       // Registro da 1ª área, com os totais agregados
+    int qtd_turmas;            // Turmas distintas em que leciona
+    int qtd_alunos;            // Alunos distintos atendidos
+    int qtd_vinculos;          // Disciplinas de alunos vinculadas a ele
+    long soma_medias;          // Soma das media_final dessas disciplinas (centésimos)
+    CargaTurma *cargas;        // Um item por (turma, disciplina) que leciona
+    int qtd_cargas, cap_cargas;
     struct Professor *proximo; // Ponteiro para o próximo professor na lista global
 } Professor;
 
@@ -29,10 +112,32 @@ typedef struct Disciplina {
        Sempre use 'desvincular_professor_alunos' antes de dar free em um Professor. */
     Professor *docente;         
     Unidade unidades[4];        // Array fixo para os 4 bimestres
-    float media_final;          // Média aritmética das 4 unidades
+    Nota media_final;           // Média anual em centésimos (mantida por gravar_nota/reavaliar_*)
+    Nota recuperacao;           // Prova de recuperação (0 = não realizada)
+    uint64_t chamada[PRESENCA_PALAVRAS];  // Bit d: houve chamada no dia letivo d+1 com o aluno na turma
+    uint64_t presenca[PRESENCA_PALAVRAS]; // Bit d: presente nesse dia (subconjunto de 'chamada')
     struct Disciplina *proximo; // Ponteiro para a próxima disciplina da grade
 } Disciplina;
 
+// Classes de prioridade da fila de espera (menor valor = atendido antes)
+typedef enum {
+    PRIORIDADE_IRMAO,           // Irmão de aluno matriculado
+    PRIORIDADE_FUNCIONARIO,     // Filho de funcionário
+    PRIORIDADE_TRANSFERENCIA,   // Transferência de outra escola
+    PRIORIDADE_GERAL,
+    PRIORIDADE_CLASSES
+} PrioridadeFila;
+
+static const char *NOMES_PRIORIDADE[] = {"irmao", "funcionario", "transferencia", "geral"};
+
+// Enlace de um nível superior do diário de classe (skip list, ver seção 4)
+#define ROSTER_NIVEIS 16
+
+typedef struct SaltoRoster {
+    struct Aluno *proximo;
+    int largura;                // Quantas posições do diário o enlace avança
+} SaltoRoster;
+
 // Entidade Aluno: Nó da Lista Encadeada Principal
 typedef struct Aluno {
     char matricula[20];         // Matrícula alfanumérica única
@@ -41,6 +146,17 @@ typedef struct Aluno {
     int serie;                  
     Disciplina *lista_disciplinas; // Início da lista de matérias deste aluno
     struct Aluno *proximo;      // Próximo aluno (seja na lista global ou na turma)
+    struct Turma *turma;        // Turma onde o aluno está matriculado (NULL se na fila)
+    unsigned int versao;        // Incrementada a cada alteração de nota/vínculo (dirty-tracking)
+    CacheTexto cache_boletim;   // Boletim já renderizado (válido se versao bater)
+    CacheTexto cache_relatorio; // Bloco do aluno no relatório de fechamento
+    int media_geral;            // Média (centésimos) usada no último bloco renderizado
+    int aprovado;               // Situação (média e frequência) do último bloco renderizado
+    SaltoRoster *saltos;        // Níveis 1.. do diário da turma (o nível 0 é 'proximo')
+    int nivel_roster;           // Altura do nó no diário (1 = só o nível 0)
+    PrioridadeFila prioridade;  // Classe usada se o aluno cair na fila de espera
+    unsigned long chegada_fila; // Ordem de chegada na fila (desempate FIFO)
+    int posicao_fila;           // Posição no heap da fila da série (-1 se fora da fila)
 } Aluno;
 
 // Entidade Turma: Container que organiza o encontro de Alunos e Professores
@@ -52,8 +168,67 @@ typedef struct Turma {
     Professor *professor_regente; // Professor responsável pela turma
     Aluno *lista_alunos;          // Início da lista de alunos desta turma
     struct Turma *proximo_turma;  // Próximo nó na lista global de turmas
+    unsigned int versao;          // Incrementada em matrícula, remoção ou edição de qualquer aluno
+    CacheTexto cache_relatorio;   // Relatório de fechamento já renderizado
+    struct HistoricoTurma *historico; // Log append-only das notas lançadas (NULL até o 1º lançamento)
+    SaltoRoster roster[ROSTER_NIVEIS - 1]; // Cabeças dos níveis 1.. do diário (nível 0 = lista_alunos)
+    int nivel_roster;             // Níveis em uso no diário
+    PlanoAvaliacao *plano;        // Regra própria da turma (NULL = regra da série)
 } Turma;
 
+/* --- Historico versionado de notas (ver secao 2.4) --- */
+
+#define MAX_DISCIPLINAS    10          // Maior grade curricular (Ensino Medio)
+#define HIST_BLOCO         512         // Registros por bloco do log da turma
+#define HIST_CHECKPOINT    32          // A cada N registros do aluno, um quadro completo
+#define HIST_SEM_REGISTRO  UINT32_MAX
+
+// Um lancamento de nota: 16 bytes, instante em delta sobre a base do bloco
+typedef struct {
+    uint32_t delta_seg;   // Segundos desde BlocoHistorico::base
+    uint32_t anterior;    // Registro anterior do mesmo aluno (HIST_SEM_REGISTRO se primeiro)
+    uint16_t aluno;       // Indice em HistoricoTurma::alunos
+    uint16_t docente;     // Indice+1 em HistoricoTurma::docentes (0 = sem docente)
+    Nota     valor;
+    uint8_t  slot;        // disciplina*8 + unidade*2 + (prova-1)
+} RegistroHistorico;
+
+typedef struct {
+    time_t base;                        // Instante do primeiro registro do bloco
+    RegistroHistorico reg[HIST_BLOCO];
+} BlocoHistorico;
+
+// Quadro completo do aluno apos o registro 'registro'
+typedef struct {
+    uint32_t registro;
+    time_t   instante;
+    Unidade  quadro[MAX_DISCIPLINAS][4];
+    uint32_t origem[MAX_DISCIPLINAS * 8]; // Registro que definiu cada prova
+    time_t   lacuna;                      // Desde quando falta o checkpoint seguinte (0 = nenhuma)
+} CheckpointHistorico;
+
+typedef struct {
+    char     matricula[20];
+    int      serie;
+    uint32_t ultimo;                      // Registro mais recente deste aluno
+    int      desde_checkpoint;
+    Unidade  quadro[MAX_DISCIPLINAS][4];  // Estado corrente (base do proximo checkpoint)
+    uint32_t origem[MAX_DISCIPLINAS * 8];
+    CheckpointHistorico *checkpoints;     // Ordenados por instante
+    int      qtd_checkpoints, cap_checkpoints;
+} AlunoHistorico;
+
+typedef struct HistoricoTurma {
+    BlocoHistorico **blocos;
+    uint32_t qtd_blocos, cap_blocos;
+    uint32_t total;                       // Registros no log
+    AlunoHistorico *alunos;
+    int qtd_alunos, cap_alunos;
+    char (*docentes)[15];                 // IDs de professores (dicionario)
+    int qtd_docentes, cap_docentes;
+    time_t ultimo_instante;
+} HistoricoTurma;
+
 /* ==========================================================================
    2. DADOS PREDEFINIDOS (GRADE CURRICULAR KOLPING)
    ========================================================================== */
@@ -61,665 +236,5825 @@ typedef struct Turma {
 const char *DISCIPLINAS_FUNDAMENTAL[] = {"Portugues", "Matematica", "Historia", "Geografia", "Ciencias", "Ingles", "Artes", "Educacao Fisica"};
 const char *DISCIPLINAS_MEDIO[] = {"Portugues", "Matematica", "Historia", "Geografia", "Fisica", "Quimica", "Biologia", "Ingles", "Filosofia", "Sociologia"};
 
+// Departamento responsável por cada disciplina (alocação automática de docentes)
+static const struct { const char *disciplina, *departamento; } DEPARTAMENTO_DISCIPLINA[] = {
+    {"Portugues", "Linguagens"}, {"Ingles", "Linguagens"}, {"Artes", "Linguagens"},
+    {"Educacao Fisica", "Linguagens"}, {"Matematica", "Exatas"}, {"Fisica", "Exatas"},
+    {"Quimica", "Exatas"}, {"Ciencias", "Ciencias"}, {"Biologia", "Ciencias"},
+    {"Historia", "Humanas"}, {"Geografia", "Humanas"}, {"Filosofia", "Humanas"},
+    {"Sociologia", "Humanas"}
+};
+#define QTD_DISCIPLINAS_DEPTO ((int) (sizeof(DEPARTAMENTO_DISCIPLINA) / sizeof(DEPARTAMENTO_DISCIPLINA[0])))
+
 /* ==========================================================================
-   3. GESTÃO DE PROFESSORES (CRUD & SEGURANÇA)
+   2.0 RASTREAMENTO DE DESEMPENHO (TRACE EVENTS DO CHROME/PERFETTO)
    ========================================================================== */
 
-// Cria um professor na memória e gera seu e-mail institucional
-Professor* criar_professor(char *id, char *nome, char *depto) {
-    Professor *novo = (Professor*) malloc(sizeof(Professor));
-    if (!novo) return NULL;
-    strcpy(novo->id, id);
-    strcpy(novo->nome, nome);
-    strcpy(novo->departamento, depto);
-    sprintf(novo->email_funcional, "%s.%s@docente.kolping.edu.br", novo->nome, novo->id);
-    novo->proximo = NULL;
-    return novo;
+/* RASTREAR("nome") no início de uma função abre um intervalo que se fecha
+   sozinho na saída do escopo (__attribute__((cleanup))). Cada thread grava
+   seus intervalos num buffer próprio, sem travas; no encerramento todos os
+   buffers viram um JSON de trace events ("ph":"X"), aberto em
+   chrome://tracing ou ui.perfetto.dev. Ative com KOLPING_RASTREIO=arquivo.json.
+   Desligado, cada intervalo custa uma leitura atômica relaxada; compilando
+   com -DKOLPING_SEM_RASTREIO (ou sem GCC/Clang) a instrumentação some.
+   Threads de vida curta (importação, campi, exportação) são recriadas a cada
+   uso: ao terminar, o buffer da thread vai para uma lista de livres e a
+   próxima thread com o mesmo nome continua nele, na mesma linha do trace.
+   Os blocos começam pequenos e dobram até RASTREIO_EVENTOS_BLOCO. */
+
+#if !defined(KOLPING_SEM_RASTREIO) && defined(__GNUC__)
+
+#define RASTREIO_EVENTOS_INICIAL 256         // Eventos do primeiro bloco de um buffer
+#define RASTREIO_EVENTOS_BLOCO   16384       // Teto de eventos por bloco
+#define RASTREIO_MAX_BLOCOS      64          // Além disso, intervalos são contados e descartados
+
+typedef struct {
+    const char *nome;           // Literal: o ponteiro vale até o fim do programa
+    uint64_t inicio, duracao;   // Nanossegundos desde iniciar_rastreio
+} EventoRastreio;
+
+typedef struct BlocoRastreio {
+    uint32_t qtd, cap;
+    struct BlocoRastreio *proximo;
+    EventoRastreio eventos[];
+} BlocoRastreio;
+
+// Só a thread dona escreve; o JSON é lido após o término das threads de fundo
+typedef struct BufferRastreio {
+    BlocoRastreio *primeiro, *atual;
+    int qtd_blocos;
+    uint32_t descartados;
+    int tid;
+    const char *nome_thread;
+    struct BufferRastreio *proximo;
+    struct BufferRastreio *proximo_livre;   // Na lista de livres (thread dona terminou)
+} BufferRastreio;
+
+typedef struct {
+    const char *nome;
+    uint64_t inicio;            // 0 = rastreio desligado na abertura
+} SpanRastreio;
+
+static _Atomic int rastreio_ativo = 0;
+static _Atomic int rastreio_tids = 0;
+static _Atomic(BufferRastreio*) rastreio_buffers = NULL;
+static _Thread_local BufferRastreio *rastreio_local = NULL;
+static BufferRastreio *rastreio_livres = NULL;
+static pthread_mutex_t rastreio_trava_livres = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t rastreio_chave;
+static pthread_once_t rastreio_chave_criada = PTHREAD_ONCE_INIT;
+static uint64_t rastreio_origem = 0;
+static char rastreio_caminho[256];
+
+static uint64_t rastreio_agora(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
 }
 
-// Adiciona o professor no início da lista global (O(1))
-void inserir_professor_global(Professor **cabeca, Professor *novo) {
-    if (!novo) return;
-    novo->proximo = *cabeca;
-    *cabeca = novo;
+// Destrutor da chave: a thread terminou e o buffer fica disponível para reuso
+static void rastreio_liberar_buffer(void *p) {
+    BufferRastreio *b = (BufferRastreio*) p;
+    pthread_mutex_lock(&rastreio_trava_livres);
+    b->proximo_livre = rastreio_livres;
+    rastreio_livres = b;
+    pthread_mutex_unlock(&rastreio_trava_livres);
 }
 
-// Localiza um professor pelo seu ID único
-Professor* buscar_professor(Professor *cabeca, char *id_procurado) {
-    Professor *atual = cabeca;
-    while (atual) {
-        if (strcmp(atual->id, id_procurado) == 0) return atual;
-        atual = atual->proximo;
-    }
-    return NULL;
+static void rastreio_criar_chave(void) {
+    pthread_key_create(&rastreio_chave, rastreio_liberar_buffer);
 }
 
-// NOVO: Função de Segurança contra 'Dangling Pointers'
-// Antes de remover um professor, esta função percorre todos os alunos e limpa os vínculos
-void desvincular_professor_alunos(Aluno *lista_alunos, Professor *p_removido) {
-    Aluno *a_atual = lista_alunos;
-    while (a_atual != NULL) {
-        Disciplina *d_atual = a_atual->lista_disciplinas;
-        while (d_atual != NULL) {
-            if (d_atual->docente == p_removido) {
-                d_atual->docente = NULL; // O aluno agora está "sem professor" nesta matéria
-            }
-            d_atual = d_atual->proximo;
+// Tira da lista de livres um buffer de thread com o mesmo nome (NULL = sem nome)
+static BufferRastreio* rastreio_reaproveitar(const char *nome) {
+    BufferRastreio *b = NULL;
+    pthread_mutex_lock(&rastreio_trava_livres);
+    for (BufferRastreio **p = &rastreio_livres; *p; p = &(*p)->proximo_livre) {
+        const char *n = (*p)->nome_thread;
+        if (n == nome || (n && nome && strcmp(n, nome) == 0)) {
+            b = *p;
+            *p = b->proximo_livre;
+            break;
         }
-        a_atual = a_atual->proximo;
     }
+    pthread_mutex_unlock(&rastreio_trava_livres);
+    return b;
 }
 
-// Remove um professor da lista global e libera a memória
-void remover_professor_global(Professor **cabeca, char *id_remover) {
-    Professor *atual = *cabeca, *anterior = NULL;
-    while (atual && strcmp(atual->id, id_remover) != 0) {
-        anterior = atual;
-        atual = atual->proximo;
+/* Buffer da thread atual: no primeiro uso reaproveita o de uma thread já
+   encerrada com o mesmo nome ou cria e publica (push lock-free) um novo. */
+static BufferRastreio* rastreio_buffer_nomeado(const char *nome) {
+    if (rastreio_local) return rastreio_local;
+    pthread_once(&rastreio_chave_criada, rastreio_criar_chave);
+    BufferRastreio *b = rastreio_reaproveitar(nome);
+    if (!b) {
+        b = (BufferRastreio*) calloc(1, sizeof(BufferRastreio));
+        if (!b) return NULL;
+        b->tid = atomic_fetch_add(&rastreio_tids, 1) + 1;
+        b->nome_thread = nome;
+        b->proximo = atomic_load(&rastreio_buffers);
+        while (!atomic_compare_exchange_weak(&rastreio_buffers, &b->proximo, b)) {}
     }
-    if (!atual) return;
-    if (!anterior) *cabeca = atual->proximo;
-    else anterior->proximo = atual->proximo;
-    
-    printf("Sistema Kolping: Memoria do docente %s liberada.\n", atual->nome);
-    free(atual);
+    pthread_setspecific(rastreio_chave, b);
+    rastreio_local = b;
+    return b;
 }
 
-void listar_professores(Professor *cabeca) {
-    printf("\n--- LISTA DE DOCENTES KOLPING ---\n");
-    while (cabeca) {
-        printf("ID: %-10s | Nome: %-20s | Depto: %s\n", cabeca->id, cabeca->nome, cabeca->departamento);
-        cabeca = cabeca->proximo;
-    }
+static BufferRastreio* rastreio_buffer(void) {
+    return rastreio_buffer_nomeado(NULL);
 }
 
-/* ==========================================================================
-   4. GESTÃO DE ALUNOS E TURMAS
-   ========================================================================== */
-
-// Matricula o aluno e já aloca todas as disciplinas baseadas na série
-Aluno* matricular_aluno(char *matricula, char *nome, int serie) {
-    Aluno *novo = (Aluno*) malloc(sizeof(Aluno));
-    if (!novo) return NULL;
-    strcpy(novo->matricula, matricula);
-    strcpy(novo->nome, nome);
-    novo->serie = serie;
-    sprintf(novo->email_academico, "%s.%s@kolping.edu.br", novo->matricula, novo->nome);
-    novo->lista_disciplinas = NULL;
-    novo->proximo = NULL;
-
-    int qtd = (serie >= 10) ? 10 : 8;
-    const char **nomes = (serie >= 10) ? DISCIPLINAS_MEDIO : DISCIPLINAS_FUNDAMENTAL;
-
-    for (int i = 0; i < qtd; i++) {
-        Disciplina *d = (Disciplina*) malloc(sizeof(Disciplina));
-        strcpy(d->nome, nomes[i]);
-        d->docente = NULL;
-        for (int u = 0; u < 4; u++) {
-            d->unidades[u].prova1 = d->unidades[u].prova2 = d->unidades[u].media_unidade = 0;
-        }
-        d->proximo = novo->lista_disciplinas;
-        novo->lista_disciplinas = d;
-    }
-    return novo;
+static inline SpanRastreio rastreio_inicio(const char *nome) {
+    SpanRastreio s = {nome, 0};
+    if (atomic_load_explicit(&rastreio_ativo, memory_order_relaxed)) s.inicio = rastreio_agora();
+    return s;
 }
 
-Aluno* buscar_aluno(Aluno *cabeca, char *mat) {
-    while (cabeca) {
-        if (strcmp(cabeca->matricula, mat) == 0) return cabeca;
-        cabeca = cabeca->proximo;
+static void rastreio_fim(SpanRastreio *s) {
+    if (!s->inicio) return;
+    uint64_t fim = rastreio_agora();
+    BufferRastreio *b = rastreio_buffer();
+    if (!b) return;
+    BlocoRastreio *bl = b->atual;
+    if (!bl || bl->qtd == bl->cap) {
+        uint32_t cap = bl ? bl->cap * 2 : RASTREIO_EVENTOS_INICIAL;
+        if (cap > RASTREIO_EVENTOS_BLOCO) cap = RASTREIO_EVENTOS_BLOCO;
+        BlocoRastreio *novo = (b->qtd_blocos < RASTREIO_MAX_BLOCOS)
+            ? (BlocoRastreio*) malloc(sizeof(BlocoRastreio) + cap * sizeof(EventoRastreio)) : NULL;
+        if (!novo) { b->descartados++; return; }
+        novo->qtd = 0;
+        novo->cap = cap;
+        novo->proximo = NULL;
+        if (bl) bl->proximo = novo; else b->primeiro = novo;
+        b->atual = bl = novo;
+        b->qtd_blocos++;
     }
-    return NULL;
+    EventoRastreio *e = &bl->eventos[bl->qtd++];
+    e->nome = s->nome;
+    e->inicio = s->inicio - rastreio_origem;
+    e->duracao = fim - s->inicio;
 }
 
-// Liberação de memória em cascata: Primeiro as disciplinas, depois o aluno
-void deletar_aluno(Aluno *aluno) {
-    if (!aluno) return;
-    Disciplina *atual = aluno->lista_disciplinas;
-    while (atual) {
-        Disciplina *temp = atual;
-        atual = atual->proximo;
-        free(temp);
-    }
-    free(aluno);
-}
+#define RASTREIO_CONCAT2(a, b) a##b
+#define RASTREIO_CONCAT(a, b)  RASTREIO_CONCAT2(a, b)
+#define RASTREAR(nome) \
+    SpanRastreio RASTREIO_CONCAT(span_rastreio_, __LINE__) \
+        __attribute__((cleanup(rastreio_fim), unused)) = rastreio_inicio(nome)
 
-Turma* criar_turma(char *codigo, int serie, int vagas) {
-    Turma *nova = (Turma*) malloc(sizeof(Turma));
-    if (!nova) return NULL;
-    strcpy(nova->codigo, codigo);
-    nova->serie = serie;
-    nova->limite_vagas = vagas;
-    nova->qtd_atual = 0;
-    nova->professor_regente = NULL;
-    nova->lista_alunos = NULL;
-    nova->proximo_turma = NULL;
-    return nova;
+// Nome exibido na linha da thread no visualizador
+static void rastreio_nomear_thread(const char *nome) {
+    if (!atomic_load_explicit(&rastreio_ativo, memory_order_relaxed)) return;
+    BufferRastreio *b = rastreio_buffer_nomeado(nome);
+    if (b && !b->nome_thread) b->nome_thread = nome;
 }
 
-void inserir_turma_lista(Turma **lista_global, Turma *nova) {
-    if (!nova) return;
-    nova->proximo_turma = *lista_global;
-    *lista_global = nova;
+int iniciar_rastreio(const char *caminho) {
+    snprintf(rastreio_caminho, sizeof(rastreio_caminho), "%s", caminho);
+    rastreio_origem = rastreio_agora() - 1; // Nenhum início registrado vale 0
+    atomic_store(&rastreio_ativo, 1);
+    rastreio_nomear_thread("principal");
+    return 1;
 }
 
-// Adiciona aluno na turma respeitando o limite físico de vagas
-void vincular_aluno_turma(Turma *t, Aluno *a) {
-    if (t->qtd_atual >= t->limite_vagas) {
-        printf("ALERTA: Turma %s lotada! %s deve aguardar vaga.\n", t->codigo, a->nome);
-        return;
+/* Desliga o rastreio e grava o JSON. Chamar depois de encerradas as threads
+   de fundo (os buffers delas continuam válidos após o término). */
+void encerrar_rastreio(void) {
+    if (!atomic_exchange(&rastreio_ativo, 0)) return;
+    FILE *arq = fopen(rastreio_caminho, "w");
+    BufferRastreio *b = atomic_exchange(&rastreio_buffers, NULL);
+    if (arq) {
+        setvbuf(arq, NULL, _IOFBF, 1 << 20);
+        fprintf(arq, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        int primeiro = 1;
+        for (BufferRastreio *x = b; x; x = x->proximo) {
+            if (x->nome_thread) {
+                fprintf(arq, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\","
+                             "\"args\":{\"name\":\"%s\"}}", primeiro ? "" : ",\n", x->tid, x->nome_thread);
+                primeiro = 0;
+            }
+            for (BlocoRastreio *bl = x->primeiro; bl; bl = bl->proximo)
+                for (uint32_t i = 0; i < bl->qtd; i++) {
+                    const EventoRastreio *e = &bl->eventos[i];
+                    fprintf(arq, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f}",
+                            primeiro ? "" : ",\n", x->tid, e->nome, e->inicio / 1000.0, e->duracao / 1000.0);
+                    primeiro = 0;
+                }
+            if (x->descartados)
+                fprintf(stderr, "[RASTREIO] Thread %d: %u intervalo(s) descartados (buffer cheio).\n",
+                        x->tid, x->descartados);
+        }
+        fprintf(arq, "\n]}\n");
+        fclose(arq);
     }
-    a->proximo = t->lista_alunos;
-    t->lista_alunos = a;
-    t->qtd_atual++;
+    while (b) {
+        BufferRastreio *prox = b->proximo;
+        while (b->primeiro) {
+            BlocoRastreio *bl = b->primeiro;
+            b->primeiro = bl->proximo;
+            free(bl);
+        }
+        free(b);
+        b = prox;
+    }
+    pthread_mutex_lock(&rastreio_trava_livres);
+    rastreio_livres = NULL;
+    pthread_mutex_unlock(&rastreio_trava_livres);
+    if (rastreio_local) pthread_setspecific(rastreio_chave, NULL);
+    rastreio_local = NULL;
 }
 
+#else
+
+#define RASTREAR(nome) ((void) 0)
+#define rastreio_nomear_thread(nome) ((void) 0)
+static int iniciar_rastreio(const char *caminho) { (void) caminho; return 0; }
+static void encerrar_rastreio(void) {}
+
+#endif
+
 /* ==========================================================================
-   5. OPERAÇÕES ACADÊMICAS (PORTAL DO DOCENTE)
+   2.1 CACHE DE RELATÓRIOS (DIRTY-TRACKING POR VERSÃO)
    ========================================================================== */
 
-// Vincula um professor da lista global a uma disciplina específica de um aluno
-void atribuir_professor(Aluno *a, char *nome_materia, Professor *p) {
-    if (!a || !p) return;
-    Disciplina *atual = a->lista_disciplinas;
-    while (atual != NULL) {
-        if (strcmp(atual->nome, nome_materia) == 0) {
-            atual->docente = p;
-            return;
-        }
-        atual = atual->proximo;
+/* Acrescenta texto formatado ao buffer, crescendo a capacidade em dobro. */
+static void texto_printf(Texto *t, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+    if (n < 0) return;
+
+    size_t necessario = t->tamanho + (size_t)n + 1;
+    if (necessario > t->capacidade) {
+        size_t nova_cap = t->capacidade ? t->capacidade : 256;
+        while (nova_cap < necessario) nova_cap *= 2;
+        char *novo = (char*) realloc(t->dados, nova_cap);
+        if (!novo) return;
+        t->dados = novo;
+        t->capacidade = nova_cap;
     }
+    va_start(args, fmt);
+    vsnprintf(t->dados + t->tamanho, (size_t)n + 1, fmt, args);
+    va_end(args);
+    t->tamanho += (size_t)n;
 }
 
-// Lança notas e calcula automaticamente a média da unidade
-void lancar_nota(Aluno *lista, char *mat, char *materia, int unidade, int prova, float nota) {
-    Aluno *a = buscar_aluno(lista, mat);
-    if (!a) return;
-    Disciplina *d = a->lista_disciplinas;
-    while (d) {
-        if (strcmp(d->nome, materia) == 0) {
-            if (unidade < 1 || unidade > 4) return;
-            if (prova == 1) d->unidades[unidade-1].prova1 = nota;
-            else d->unidades[unidade-1].prova2 = nota;
-            
-            // Média Simples por Unidade
-            d->unidades[unidade-1].media_unidade = (d->unidades[unidade-1].prova1 + d->unidades[unidade-1].prova2) / 2.0;
-            return;
-        }
-        d = d->proximo;
+/* Acrescenta um bloco ja renderizado (sem reformatar). */
+static void texto_anexar(Texto *t, const Texto *origem) {
+    if (!origem->dados || origem->tamanho == 0) return;
+    size_t necessario = t->tamanho + origem->tamanho + 1;
+    if (necessario > t->capacidade) {
+        size_t nova_cap = t->capacidade ? t->capacidade : 256;
+        while (nova_cap < necessario) nova_cap *= 2;
+        char *novo = (char*) realloc(t->dados, nova_cap);
+        if (!novo) return;
+        t->dados = novo;
+        t->capacidade = nova_cap;
     }
+    memcpy(t->dados + t->tamanho, origem->dados, origem->tamanho + 1);
+    t->tamanho += origem->tamanho;
 }
 
-// Percorre as disciplinas e exibe as médias finais e professores vinculados
-void exibir_boletim(Aluno *a) {
-    if (!a) return;
-    printf("\n========= BOLETIM KOLPING: %s (%s) =========\n", a->nome, a->matricula);
-    Disciplina *d = a->lista_disciplinas;
-    while (d) {
-        float soma = 0;
-        for(int i=0; i<4; i++) soma += d->unidades[i].media_unidade;
-        d->media_final = soma / 4.0; // Média Final Anual
-        
-        printf("- %-15s | Media Final: %.2f | Prof: %s\n", 
-                d->nome, d->media_final, d->docente ? d->docente->nome : "N/A");
-        d = d->proximo;
-    }
-    printf("======================================================\n");
+/* Esvazia o buffer mantendo a memoria para a proxima renderizacao. */
+static void texto_limpar(Texto *t) {
+    t->tamanho = 0;
+    if (t->dados) t->dados[0] = '\0';
+}
 
+static void texto_liberar(Texto *t) {
+    free(t->dados);
+    t->dados = NULL;
+    t->tamanho = t->capacidade = 0;
 }
 
+/* Conteudo para exibir: "" se o buffer nunca chegou a ser alocado (falta
+   de memoria na primeira renderizacao). */
+static const char* texto_conteudo(const Texto *t) {
+    return t->dados ? t->dados : "";
+}
+
+/* Um cache so e servido se foi renderizado na versao atual do dono. */
+static int cache_valido(const CacheTexto *c, unsigned int versao_dono) {
+    return c->versao != 0 && c->versao == versao_dono && c->texto.dados != NULL;
+}
+
+/* Toda alteracao que muda o boletim do aluno passa por aqui: invalida o
+   cache do aluno e o relatorio da turma onde ele esta matriculado. */
+static void marcar_aluno_alterado(Aluno *a) {
+    if (!a) return;
+    a->versao++;
+    if (a->turma) a->turma->versao++;
+}
 
+/* Matricula/remocao mudam a composicao da turma (cabecalho e totais). */
+static void marcar_turma_alterada(Turma *t) {
+    if (t) t->versao++;
+}
 
 /* ==========================================================================
-FILA DE ESPERA E CONTROLE DE VAGAS
+   2.2 NOTAS EM PONTO FIXO (CENTÉSIMOS)
    ========================================================================== */
 
-// 1. ESTRUTURA DA FILA
-// Usamos um nó específico para a fila que apenas "aponta" para o aluno,
-// assim não quebramos o ponteiro "proximo" da lista encadeada original.
-typedef struct NoFila {
-    Aluno *aluno;
-    struct NoFila *proximo;
-} NoFila;
+/* Converte a nota digitada (0.0-10.0, ate duas casas) para centesimos.
+   Valores grandes saturam em UINT16_MAX (sem dar a volta), para que a
+   checagem de NOTA_MAXIMA de quem chama continue recusando-os. */
+static Nota nota_de_float(float valor) {
+    if (valor <= 0.0f) return 0;
+    float centesimos = valor * NOTA_ESCALA + 0.5f;
+    if (centesimos >= (float) UINT16_MAX) return UINT16_MAX;
+    return (Nota) centesimos;
+}
 
-typedef struct FilaEspera {
-    NoFila *inicio;
-    NoFila *fim;
-    int quantidade;
-} FilaEspera;
+/* Converte centesimos para exibicao com printf. */
+static float nota_para_float(int centesimos) {
+    return (float)centesimos / NOTA_ESCALA;
+}
 
-// 2. FUNÇÕES BÁSICAS DA FILA (CRUD DA FILA)
+/* --- Regras de avaliacao ---
+   Uma regra em texto ("unidades=2,2,3,3; provas=1,1; recuperacao=menor;
+   aprovacao=6.0") e compilada uma unica vez num PlanoAvaliacao. A regra vale
+   por serie e pode ser sobrescrita por turma; a resolucao e turma -> serie ->
+   padrao. A regra padrao reproduz a media historica: soma das 8 provas / 8. */
 
-FilaEspera* criar_fila() {
-    FilaEspera *f = (FilaEspera*) malloc(sizeof(FilaEspera));
-    f->inicio = NULL;
-    f->fim = NULL;
-    f->quantidade = 0;
-    return f;
+static PlanoAvaliacao PLANO_PADRAO = {
+    {1, 1}, {1, 1, 1, 1}, 2, 8, 0, MEDIA_APROVACAO,
+    "unidades=1,1,1,1; provas=1,1; recuperacao=nenhuma; aprovacao=5.00"
+};
+
+static PlanoAvaliacao *planos_serie[13]; // Indice = serie (NULL = padrao)
+
+static const PlanoAvaliacao* plano_turma(const Turma *t) {
+    if (!t) return &PLANO_PADRAO;
+    if (t->plano) return t->plano;
+    if (t->serie >= 0 && t->serie < 13 && planos_serie[t->serie]) return planos_serie[t->serie];
+    return &PLANO_PADRAO;
 }
 
-// Push/Enqueue - Insere o aluno no final da fila de espera
-void enfileirar(FilaEspera *f, Aluno *a) {
-    if (!f || !a) return;
-    
-    NoFila *novo = (NoFila*) malloc(sizeof(NoFila));
-    novo->aluno = a;
-    novo->proximo = NULL;
+/* Aluno sem turma (fila de espera) usa a regra da sua serie. */
+static const PlanoAvaliacao* plano_aluno(const Aluno *a) {
+    if (a->turma) return plano_turma(a->turma);
+    if (a->serie >= 0 && a->serie < 13 && planos_serie[a->serie]) return planos_serie[a->serie];
+    return &PLANO_PADRAO;
+}
 
-    if (f->fim == NULL) {
-        f->inicio = novo; // Fila estava vazia
-    } else {
-        f->fim->proximo = novo; // Liga o último atual ao novo
-    }
-    f->fim = novo; // O novo passa a ser o último
-    f->quantidade++;
-    
-    printf("FILA: %s adicionado a fila de espera (Posicao: %d).\n", a->nome, f->quantidade);
+/* Media da unidade em centesimos, arredondada meio-para-cima. */
+static int media_unidade(const PlanoAvaliacao *p, const Unidade *u) {
+    return (p->peso_prova[0] * u->prova1 + p->peso_prova[1] * u->prova2 + p->soma_provas / 2)
+           / p->soma_provas;
 }
 
-// Pop/Dequeue - Retira e retorna o aluno do início da fila
-Aluno* desenfileirar(FilaEspera *f) {
-    if (!f || f->inicio == NULL) return NULL; // Fila vazia
+/* Media anual pelo plano, com um unico arredondamento: cada unidade entra
+   pelo numerador (media * soma_provas), e a recuperacao, se o plano
+   permitir, substitui a menor unidade quando for maior que ela. */
+static int reavaliar_disciplina(const PlanoAvaliacao *p, Disciplina *d) {
+    uint32_t num[4];
+    for (int u = 0; u < 4; u++)
+        num[u] = (uint32_t) p->peso_prova[0] * d->unidades[u].prova1 +
+                 (uint32_t) p->peso_prova[1] * d->unidades[u].prova2;
+    if (p->recuperacao && d->recuperacao) {
+        int menor = 0;
+        for (int u = 1; u < 4; u++) if (num[u] < num[menor]) menor = u;
+        uint32_t rec = (uint32_t) d->recuperacao * p->soma_provas;
+        if (rec > num[menor]) num[menor] = rec;
+    }
+    uint64_t soma = 0;
+    for (int u = 0; u < 4; u++) soma += (uint64_t) p->peso_unidade[u] * num[u];
+    Nota nova = (Nota)((soma + p->divisor / 2) / p->divisor);
+    if (d->docente && nova != d->media_final) {
+        // Acumuladores de desempenho do professor e do departamento (seção 3)
+        long delta = (long) nova - d->media_final;
+        d->docente->soma_medias += delta;
+        if (d->docente->depto) d->docente->depto->soma_medias += delta;
+    }
+    d->media_final = nova;
+    return d->media_final;
+}
 
-    NoFila *temp = f->inicio;
-    Aluno *a_removido = temp->aluno; 
+/* Recalcula todas as disciplinas do aluno (resolvendo o plano uma vez). */
+static void reavaliar_aluno(Aluno *a) {
+    const PlanoAvaliacao *p = plano_aluno(a);
+    for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo) reavaliar_disciplina(p, d);
+}
 
-    f->inicio = f->inicio->proximo; 
-    
-    if (f->inicio == NULL) {
-        f->fim = NULL; 
+/* Le uma lista "a,b,c" de inteiros 0..100 para 'saida'. Retorna a soma ou -1. */
+static int ler_pesos_regra(const char *valor, uint16_t *saida, int qtd) {
+    int soma = 0;
+    const char *c = valor;
+    for (int i = 0; i < qtd; i++) {
+        char *fim;
+        long v = strtol(c, &fim, 10);
+        if (fim == c || v < 0 || v > 100) return -1;
+        saida[i] = (uint16_t) v;
+        soma += (int) v;
+        while (*fim == ' ') fim++;
+        if (i < qtd - 1) { if (*fim != ',') return -1; c = fim + 1; }
+        else if (*fim != '\0') return -1;
     }
-    
-    free(temp); // Libera o nó da fila, mas mantém o aluno intacto!
-    f->quantidade--;
-    
-    return a_removido;
+    return soma;
 }
 
-void exibir_fila(FilaEspera *f) {
-    if (!f || f->inicio == NULL) {
-        printf("\n[ Fila de Espera Vazia ]\n");
-        return;
+/* Compila a regra em texto. Clausulas separadas por ';', na forma chave=valor:
+     unidades=p1,p2,p3,p4   pesos dos bimestres (0..100, soma > 0)
+     provas=p1,p2           pesos das provas na unidade (0..100, soma > 0)
+     recuperacao=menor|nenhuma
+     aprovacao=x.xx         media minima (0..10)
+   Clausulas omitidas mantem o padrao. Retorna 1 ou 0 (com mensagem em 'erro'). */
+int compilar_plano(const char *regra, PlanoAvaliacao *p, char *erro, size_t cap_erro) {
+    PlanoAvaliacao novo = PLANO_PADRAO;
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", regra ? regra : "");
+    char *clausula = buf;
+    while (clausula && *clausula) {
+        char *prox = strchr(clausula, ';');
+        if (prox) *prox++ = '\0';
+        while (*clausula == ' ') clausula++;
+        char *fim = clausula + strlen(clausula);
+        while (fim > clausula && (fim[-1] == ' ' || fim[-1] == '\n' || fim[-1] == '\r')) *--fim = '\0';
+        if (*clausula) {
+            char *valor = strchr(clausula, '=');
+            if (!valor) { snprintf(erro, cap_erro, "clausula sem '=': %s", clausula); return 0; }
+            *valor++ = '\0';
+            char *k = valor - 1;
+            while (k > clausula && k[-1] == ' ') *--k = '\0';
+            while (*valor == ' ') valor++;
+            if (strcmp(clausula, "unidades") == 0) {
+                if (ler_pesos_regra(valor, novo.peso_unidade, 4) <= 0) {
+                    snprintf(erro, cap_erro, "unidades: informe 4 pesos inteiros 0..100 (soma > 0)");
+                    return 0;
+                }
+            } else if (strcmp(clausula, "provas") == 0) {
+                if (ler_pesos_regra(valor, novo.peso_prova, 2) <= 0) {
+                    snprintf(erro, cap_erro, "provas: informe 2 pesos inteiros 0..100 (soma > 0)");
+                    return 0;
+                }
+            } else if (strcmp(clausula, "recuperacao") == 0) {
+                if      (strcmp(valor, "menor") == 0)   novo.recuperacao = 1;
+                else if (strcmp(valor, "nenhuma") == 0) novo.recuperacao = 0;
+                else { snprintf(erro, cap_erro, "recuperacao: use 'menor' ou 'nenhuma'"); return 0; }
+            } else if (strcmp(clausula, "aprovacao") == 0) {
+                char *f;
+                float v = strtof(valor, &f);
+                if (f == valor || *f != '\0' || v < 0.0f || v > 10.0f) {
+                    snprintf(erro, cap_erro, "aprovacao: informe uma media entre 0 e 10");
+                    return 0;
+                }
+                novo.aprovacao = nota_de_float(v);
+            } else {
+                snprintf(erro, cap_erro, "chave desconhecida: %s", clausula);
+                return 0;
+            }
+        }
+        clausula = prox;
     }
-    printf("\n--- FILA DE ESPERA (%d alunos aguardando) ---\n", f->quantidade);
-    NoFila *atual = f->inicio;
-    int pos = 1;
-    while (atual != NULL) {
-        printf("%dº lugar - Nome: %-20s | Mat: %s\n", pos++, atual->aluno->nome, atual->aluno->matricula);
-        atual = atual->proximo;
+    novo.soma_provas = novo.peso_prova[0] + novo.peso_prova[1];
+    int soma_unidades = 0;
+    for (int u = 0; u < 4; u++) soma_unidades += novo.peso_unidade[u];
+    novo.divisor = (uint32_t) novo.soma_provas * soma_unidades;
+    snprintf(novo.regra, sizeof(novo.regra),
+             "unidades=%d,%d,%d,%d; provas=%d,%d; recuperacao=%s; aprovacao=%.2f",
+             novo.peso_unidade[0], novo.peso_unidade[1], novo.peso_unidade[2], novo.peso_unidade[3],
+             novo.peso_prova[0], novo.peso_prova[1], novo.recuperacao ? "menor" : "nenhuma",
+             nota_para_float(novo.aprovacao));
+    *p = novo;
+    return 1;
+}
+
+/* Passada em lote: resolve o plano da turma uma vez e recalcula a media
+   anual de todas as disciplinas de todos os alunos, invalidando os caches.
+   Retorna quantos alunos foram reavaliados. */
+int reavaliar_turma(Turma *t) {
+    RASTREAR("reavaliar_turma");
+    if (!t) return 0;
+    const PlanoAvaliacao *p = plano_turma(t);
+    int qtd = 0;
+    for (Aluno *a = t->lista_alunos; a; a = a->proximo, qtd++) {
+        for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo) reavaliar_disciplina(p, d);
+        marcar_aluno_alterado(a);
     }
+    return qtd;
 }
 
-// Função que decide se o aluno entra na Turma ou vai para a Fila
-void processar_matricula_turma(Turma *t, Aluno *a, FilaEspera *f) {
-    if (t->qtd_atual < t->limite_vagas) {
-        // Inserção na Lista Encadeada (Turma)
-        a->proximo = t->lista_alunos;
-        t->lista_alunos = a;
-        t->qtd_atual++;
-        printf("SUCESSO: %s matriculado na turma %s.\n", a->nome, t->codigo);
+static int guardar_plano_serie(int serie, const PlanoAvaliacao *plano) {
+    if (serie < 0 || serie >= 13) return 0;
+    if (plano) {
+        if (!planos_serie[serie]) planos_serie[serie] = malloc(sizeof(PlanoAvaliacao));
+        if (!planos_serie[serie]) return 0;
+        *planos_serie[serie] = *plano;
     } else {
-        // Lotação atingida: vai para a Fila (Integrante 2 atua)
-        printf("ALERTA: Turma %s lotada! ", t->codigo);
-        enfileirar(f, a);
+        free(planos_serie[serie]);
+        planos_serie[serie] = NULL;
     }
+    return 1;
 }
 
-// Função de remover da turma que puxa automaticamente o próximo da fila
-void remover_aluno_turma(Turma *t, char *matricula, FilaEspera *f) {
-    if (!t || !t->lista_alunos) return;
+// Recalcula as turmas da serie que nao tem regra propria
+static int reavaliar_serie(Turma *lista, int serie) {
+    int qtd = 0;
+    for (Turma *t = lista; t; t = t->proximo_turma)
+        if (t->serie == serie && !t->plano) qtd += reavaliar_turma(t);
+    return qtd;
+}
 
-    Aluno *atual = t->lista_alunos;
-    Aluno *anterior = NULL;
+/* Define (ou, com plano NULL, remove) a regra de uma serie e recalcula as
+   turmas afetadas de uma escola isolada. A tabela de regras por serie e
+   unica: numa rede com varios campi use definir_plano_serie_rede. */
+int definir_plano_serie(Turma *lista, int serie, const PlanoAvaliacao *plano) {
+    if (!guardar_plano_serie(serie, plano)) return 0;
+    return reavaliar_serie(lista, serie);
+}
 
-    while (atual != NULL && strcmp(atual->matricula, matricula) != 0) {
-        anterior = atual;
-        atual = atual->proximo;
+/* Define (ou, com plano NULL, devolve a turma a regra da serie) a regra
+   propria de uma turma e recalcula seus alunos. */
+int definir_plano_turma(Turma *t, const PlanoAvaliacao *plano) {
+    if (!t) return 0;
+    if (plano) {
+        if (!t->plano) t->plano = malloc(sizeof(PlanoAvaliacao));
+        if (!t->plano) return 0;
+        *t->plano = *plano;
+    } else {
+        free(t->plano);
+        t->plano = NULL;
     }
+    return reavaliar_turma(t);
+}
 
-    if (atual == NULL) {
-        printf("ERRO: Aluno %s nao encontrado.\n", matricula);
-        return;
-    }
+void exibir_planos(Turma *lista) {
+    printf("\n--- REGRAS DE AVALIACAO ---\n");
+    printf("Padrao   : %s\n", PLANO_PADRAO.regra);
+    for (int s = 1; s < 13; s++)
+        if (planos_serie[s]) printf("Serie %2d : %s (todos os campi)\n", s, planos_serie[s]->regra);
+    for (Turma *t = lista; t; t = t->proximo_turma)
+        if (t->plano) printf("Turma %-3s: %s\n", t->codigo, t->plano->regra);
+}
 
-    // Remove da lista
-    if (anterior == NULL) {
-        t->lista_alunos = atual->proximo;
-    } else {
-        anterior->proximo = atual->proximo;
-    }
-    t->qtd_atual--;
-    printf("AVISO: %s foi removido da turma %s. Uma vaga abriu!\n", atual->nome, t->codigo);
-    
-    atual->proximo = NULL; 
+void liberar_planos(void) {
+    for (int s = 0; s < 13; s++) { free(planos_serie[s]); planos_serie[s] = NULL; }
+}
 
-    // Automação: Puxa o primeiro da fila para preencher a vaga
-    if (f->quantidade > 0) {
-        Aluno *promovido = desenfileirar(f);
-        if (promovido) {
-            printf(">> SISTEMA: Promovendo o proximo da fila de espera...\n");
-            processar_matricula_turma(t, promovido, f); 
-        }
-    }
-}
+/* ==========================================================================
+   2.3 EVENTOS DE ALTERAÇÃO (CHANGE-DATA-CAPTURE)
+   ========================================================================== */
 
-/* ============================================================
-   ESTRUTURA PILHA (DESFAZER AÇÕES)
-   ============================================================ */
+/* Notas, matriculas, remocoes e movimentos da fila de espera geram eventos
+   tipados num anel lock-free de produtor unico (a thread do menu). Uma
+   thread de fundo drena o anel em lotes e grava uma linha JSON por evento
+   num arquivo que e rotacionado ao atingir o tamanho maximo. Anel cheio
+   nao descarta eventos: o produtor espera o consumidor abrir espaco.
+   Sem barramento iniciado, emitir um evento custa um teste de ponteiro. */
 
-// Cada ação representa uma operação que pode ser desfeita
-typedef struct Acao {
-    char tipo[20];       // Tipo da ação: "nota", "professor_removido", "aluno_removido"
-    void *dado;          // Ponteiro genérico para o dado que será restaurado
-    struct Acao *proximo; 
-} Acao;
+#define EVENTOS_CAPACIDADE     4096          // Potencia de 2
+#define EVENTOS_LOTE           256           // Eventos por escrita no arquivo
+#define EVENTOS_TAMANHO_MAX    (8L << 20)    // Rotaciona a cada 8 MB
+#define EVENTOS_ROTACOES       5             // Mantem arquivo.1 ... arquivo.5
 
-// Pilha que mantém o topo das ações salvas
-typedef struct Pilha {
-    Acao *topo;           
-} Pilha;
+typedef enum {
+    EVENTO_NOTA,
+    EVENTO_MATRICULA,
+    EVENTO_REMOCAO,
+    EVENTO_FILA_ENTRADA,
+    EVENTO_FILA_SAIDA
+} TipoEvento;
 
-// Função para criar uma pilha vazia
-Pilha* criarPilha() {
-    Pilha *p = (Pilha*) malloc(sizeof(Pilha)); 
-    if (!p) return NULL;                       
-    p->topo = NULL;                             // Inicialmente, a pilha está vazia
-    return p;
-}
+static const char *NOMES_EVENTO[] = {"nota", "matricula", "remocao", "fila_entrada", "fila_saida"};
 
-// Função para salvar uma ação na pilha antes de qualquer alteração
-void salvar_acao(Pilha *p, char *tipo, void *dado) {
-    if (!p || !tipo || !dado) return;          
+typedef struct {
+    uint64_t   seq;
+    time_t     instante;
+    TipoEvento tipo;
+    char       turma[10];
+    char       matricula[20];
+    char       disciplina[50];
+    int        unidade;
+    int        prova;
+    int        valor;       // Nota em centesimos, ou alunos aguardando na fila da serie
+} EventoEscola;
 
-    Acao *novo = (Acao*) malloc(sizeof(Acao)); 
-    strcpy(novo->tipo, tipo);                  // Copia o tipo da ação
-    novo->dado = dado;                         // Salva o ponteiro para o dado
-    novo->proximo = p->topo;                   // Faz o novo apontar para o topo atual
-    p->topo = novo;                            // Atualiza o topo da pilha para o novo nó
+typedef struct {
+    EventoEscola *anel;
+    _Atomic uint64_t escrita;     // Proxima posicao a produzir (so o produtor escreve)
+    _Atomic uint64_t leitura;     // Proxima posicao a consumir (so o consumidor escreve)
+    _Atomic int      ativo;
+    uint64_t         seq;
+    pthread_t        thread;
+    pthread_mutex_t  trava;       // Usados apenas para acordar o consumidor ocioso
+    pthread_cond_t   sinal;
+    FILE            *arquivo;
+    char             caminho[256];
+    long             escrito;     // Bytes no arquivo atual
+    uint64_t         descartados; // Eventos que nao chegaram ao disco (escrita curta)
+} BarramentoEventos;
+
+static BarramentoEventos *barramento = NULL;
+
+/* Copia uma string para JSON, escapando aspas, barras e controles. */
+static size_t json_escapar(char *dst, size_t cap, const char *src) {
+    size_t n = 0;
+    for (; *src && n + 7 < cap; src++) {
+        unsigned char c = (unsigned char) *src;
+        if (c == '"' || c == '\\') { dst[n++] = '\\'; dst[n++] = (char) c; }
+        else if (c < 0x20) n += (size_t) snprintf(dst + n, cap - n, "\\u%04x", c);
+        else dst[n++] = (char) c;
+    }
+    dst[n] = '\0';
+    return n;
 }
 
-// Função para desfazer a última ação
-void desfazer(Pilha *p) {
-    if (!p || !p->topo) {                      
-        printf("Nada para desfazer!\n");
-        return;
+static int formatar_evento(const EventoEscola *e, char *buf, size_t cap) {
+    char turma[32], mat[64], disc[160];
+    json_escapar(turma, sizeof(turma), e->turma);
+    json_escapar(mat, sizeof(mat), e->matricula);
+    json_escapar(disc, sizeof(disc), e->disciplina);
+    switch (e->tipo) {
+    case EVENTO_NOTA:
+        return snprintf(buf, cap,
+            "{\"seq\":%llu,\"ts\":%lld,\"tipo\":\"%s\",\"turma\":\"%s\",\"matricula\":\"%s\","
+            "\"disciplina\":\"%s\",\"unidade\":%d,\"prova\":%d,\"nota\":%d.%02d}\n",
+            (unsigned long long) e->seq, (long long) e->instante, NOMES_EVENTO[e->tipo],
+            turma, mat, disc, e->unidade, e->prova, e->valor / NOTA_ESCALA, e->valor % NOTA_ESCALA);
+    case EVENTO_FILA_ENTRADA:
+    case EVENTO_FILA_SAIDA:
+        // Na fila: unidade = serie, prova = classe de prioridade
+        return snprintf(buf, cap,
+            "{\"seq\":%llu,\"ts\":%lld,\"tipo\":\"%s\",\"matricula\":\"%s\",\"serie\":%d,"
+            "\"prioridade\":\"%s\",\"aguardando\":%d}\n",
+            (unsigned long long) e->seq, (long long) e->instante, NOMES_EVENTO[e->tipo],
+            mat, e->unidade, NOMES_PRIORIDADE[e->prova], e->valor);
+    default:
+        return snprintf(buf, cap,
+            "{\"seq\":%llu,\"ts\":%lld,\"tipo\":\"%s\",\"turma\":\"%s\",\"matricula\":\"%s\"}\n",
+            (unsigned long long) e->seq, (long long) e->instante, NOMES_EVENTO[e->tipo],
+            turma, mat);
     }
+}
 
-    Acao *a = p->topo;                         // Pega a ação do topo
-    p->topo = a->proximo;                       // Atualiza o topo para o próximo
+/* arquivo -> arquivo.1 -> arquivo.2 ... (o mais antigo e descartado).
+   O arquivo novo e aberto antes de mexer nos antigos: se falhar, segue
+   gravando no atual e tenta de novo no proximo lote. */
+static void rotacionar_arquivo_eventos(BarramentoEventos *b) {
+    char de[300], para[300], novo_caminho[300];
+    snprintf(novo_caminho, sizeof(novo_caminho), "%s.novo", b->caminho);
+    FILE *novo = fopen(novo_caminho, "w");
+    if (!novo) return;
+    fclose(b->arquivo);
+    for (int i = EVENTOS_ROTACOES - 1; i >= 1; i--) {
+        snprintf(de, sizeof(de), "%s.%d", b->caminho, i);
+        snprintf(para, sizeof(para), "%s.%d", b->caminho, i + 1);
+        rename(de, para);
+    }
+    snprintf(para, sizeof(para), "%s.1", b->caminho);
+    rename(b->caminho, para);
+    rename(novo_caminho, b->caminho);
+    b->arquivo = novo;
+    b->escrito = 0;
+}
 
-    // Dependendo do tipo, restaura-se o estado antigo
-    if (strcmp(a->tipo, "nota") == 0) {
-        Unidade *u = (Unidade*) a->dado;       // Recupera a unidade antiga
-        
-    } 
-    else if (strcmp(a->tipo, "professor_removido") == 0) {
-        Professor *p_restaurar = (Professor*) a->dado;
-        // Reinsere o professor removido na lista global
-    } 
-    else if (strcmp(a->tipo, "aluno_removido") == 0) {
-        Aluno *a_restaurar = (Aluno*) a->dado;
-        // Reinsere o aluno removido na lista da turma
+/* Thread consumidora: formata um lote inteiro e faz uma unica escrita. */
+static void* consumidor_eventos(void *arg) {
+    BarramentoEventos *b = (BarramentoEventos*) arg;
+    static char buffer[EVENTOS_LOTE * 512];
+    for (;;) {
+        uint64_t leitura = atomic_load_explicit(&b->leitura, memory_order_relaxed);
+        uint64_t escrita = atomic_load_explicit(&b->escrita, memory_order_acquire);
+        if (leitura == escrita) {
+            if (!atomic_load(&b->ativo)) break;
+            // Ocioso: dorme ate ser acordado ou por no maximo 50 ms
+            struct timespec limite;
+            clock_gettime(CLOCK_REALTIME, &limite);
+            limite.tv_nsec += 50 * 1000000L;
+            if (limite.tv_nsec >= 1000000000L) { limite.tv_sec++; limite.tv_nsec -= 1000000000L; }
+            pthread_mutex_lock(&b->trava);
+            pthread_cond_timedwait(&b->sinal, &b->trava, &limite);
+            pthread_mutex_unlock(&b->trava);
+            continue;
+        }
+        size_t usado = 0;
+        uint64_t fim = escrita;
+        if (fim - leitura > EVENTOS_LOTE) fim = leitura + EVENTOS_LOTE;
+        for (uint64_t i = leitura; i < fim; i++) {
+            const EventoEscola *e = &b->anel[i & (EVENTOS_CAPACIDADE - 1)];
+            int n = formatar_evento(e, buffer + usado, sizeof(buffer) - usado);
+            if (n > 0) usado += (size_t) n;
+        }
+        // Slots ja copiados: libera espaco para o produtor antes do I/O
+        atomic_store_explicit(&b->leitura, fim, memory_order_release);
+        if (fwrite(buffer, 1, usado, b->arquivo) != usado || fflush(b->arquivo) != 0)
+            b->descartados += fim - leitura;
+        b->escrito += (long) usado;
+        if (b->escrito >= EVENTOS_TAMANHO_MAX) rotacionar_arquivo_eventos(b);
     }
+    return NULL;
+}
 
-    free(a);                                   // Libera a memória do nó da pilha 
+/* Inicia o barramento gravando em 'caminho'. Retorna 1 se ativo. */
+int iniciar_eventos(const char *caminho) {
+    if (barramento || !caminho) return barramento != NULL;
+    BarramentoEventos *b = (BarramentoEventos*) calloc(1, sizeof(BarramentoEventos));
+    if (!b) return 0;
+    b->anel = (EventoEscola*) malloc(EVENTOS_CAPACIDADE * sizeof(EventoEscola));
+    b->arquivo = fopen(caminho, "a");
+    if (!b->anel || !b->arquivo) {
+        if (b->arquivo) fclose(b->arquivo);
+        free(b->anel);
+        free(b);
+        return 0;
+    }
+    snprintf(b->caminho, sizeof(b->caminho), "%s", caminho);
+    b->escrito = ftell(b->arquivo);
+    atomic_init(&b->escrita, 0);
+    atomic_init(&b->leitura, 0);
+    atomic_init(&b->ativo, 1);
+    pthread_mutex_init(&b->trava, NULL);
+    pthread_cond_init(&b->sinal, NULL);
+    if (pthread_create(&b->thread, NULL, consumidor_eventos, b) != 0) {
+        fclose(b->arquivo);
+        free(b->anel);
+        free(b);
+        return 0;
+    }
+    barramento = b;
+    return 1;
 }
 
-/* ============================================================
-   ESTRUTURA PILHA PARA HISTÓRICO DE MENUS
-   ============================================================ */
+/* Publica um evento. Com o anel cheio, aplica backpressure: acorda o
+   consumidor e cede a CPU ate haver espaco. */
+static void publicar_evento(EventoEscola *e) {
+    BarramentoEventos *b = barramento;
+    uint64_t escrita = atomic_load_explicit(&b->escrita, memory_order_relaxed);
+    while (escrita - atomic_load_explicit(&b->leitura, memory_order_acquire) >= EVENTOS_CAPACIDADE) {
+        pthread_cond_signal(&b->sinal);
+        sched_yield();
+    }
+    e->seq = ++b->seq;
+    e->instante = time(NULL);
+    b->anel[escrita & (EVENTOS_CAPACIDADE - 1)] = *e;
+    atomic_store_explicit(&b->escrita, escrita + 1, memory_order_release);
+    if (escrita + 1 - atomic_load_explicit(&b->leitura, memory_order_relaxed) >= EVENTOS_LOTE)
+        pthread_cond_signal(&b->sinal);
+}
 
-// Cada nó representa uma tela/menu visitado
-typedef struct Menu {
-    int id_menu;          
-    struct Menu *proximo; 
-} Menu;
+static void emitir_evento(TipoEvento tipo, const Turma *t, const Aluno *a,
+                          const char *disciplina, int unidade, int prova, int valor) {
+    if (!barramento) return;
+    EventoEscola e;
+    memset(&e, 0, sizeof(e));
+    e.tipo = tipo;
+    if (t) snprintf(e.turma, sizeof(e.turma), "%s", t->codigo);
+    if (a) snprintf(e.matricula, sizeof(e.matricula), "%s", a->matricula);
+    if (disciplina) snprintf(e.disciplina, sizeof(e.disciplina), "%s", disciplina);
+    e.unidade = unidade;
+    e.prova = prova;
+    e.valor = valor;
+    publicar_evento(&e);
+}
 
+/* Drena o que falta no anel, encerra a thread e fecha o arquivo. */
+void encerrar_eventos(void) {
+    BarramentoEventos *b = barramento;
+    if (!b) return;
+    barramento = NULL;
+    atomic_store(&b->ativo, 0);
+    pthread_cond_signal(&b->sinal);
+    pthread_join(b->thread, NULL);
+    if (b->descartados)
+        fprintf(stderr, "[EVENTOS] %llu evento(s) nao gravados em %s (falha de escrita).\n",
+                (unsigned long long) b->descartados, b->caminho);
+    fclose(b->arquivo);
+    pthread_mutex_destroy(&b->trava);
+    pthread_cond_destroy(&b->sinal);
+    free(b->anel);
+    free(b);
+}
 
-Menu *menu_topo = NULL;
+/* ==========================================================================
+   2.4 HISTÓRICO VERSIONADO DE NOTAS (LOG APPEND-ONLY POR TURMA)
+   ========================================================================== */
 
-// Empilha ao entrar em um menu
-void entrar_menu(int id) {
-    Menu *novo = malloc(sizeof(Menu));  
-    if (!novo) return;                  
-    novo->id_menu = id;                 // Guarda o ID do menu
-    novo->proximo = menu_topo;          // Aponta para o menu anterior (topo atual)
-    menu_topo = novo;                   // Atualiza o topo da pilha
-}
+/* Cada lancamento vira um registro de 16 bytes num log em blocos da turma.
+   O instante e gravado como delta em segundos sobre a base do bloco, e o
+   aluno/docente como indices em dicionarios da propria turma. Os registros
+   de um mesmo aluno formam uma lista encadeada para tras ('anterior') e, a
+   cada HIST_CHECKPOINT registros do aluno, um quadro completo e guardado:
+   a reconstrucao "na data X" parte do checkpoint anterior a X e aplica no
+   maximo HIST_CHECKPOINT registros, sem varrer o log inteiro. */
 
-// Desempilha ao voltar para o menu anterior
-int voltar_menu() {
-    if (!menu_topo) return -1;          // Se pilha vazia, retorna -1 (nenhum menu anterior)
+/* Posicao de uma disciplina na grade curricular da serie (-1 se nao existe) */
+static int indice_disciplina(int serie, const char *nome) {
+    int qtd = (serie >= 10) ? 10 : 8;
+    const char **nomes = (serie >= 10) ? DISCIPLINAS_MEDIO : DISCIPLINAS_FUNDAMENTAL;
+    for (int i = 0; i < qtd; i++)
+        if (strcmp(nomes[i], nome) == 0) return i;
+    return -1;
+}
 
-    Menu *temp = menu_topo;             // Guarda o topo atual
-    menu_topo = menu_topo->proximo;     // Atualiza o topo para o próximo da pilha
-    int id = temp->id_menu;             // Recupera o ID do menu a retornar
-    free(temp);                         // Libera a memória do nó desempilhado
-    return id;                          // Retorna o ID do menu anterior
+static const char* nome_disciplina(int serie, int indice) {
+    return (serie >= 10) ? DISCIPLINAS_MEDIO[indice] : DISCIPLINAS_FUNDAMENTAL[indice];
 }
 
-/* Valida se a nota esta entre 0.0 e 10.0.
-   Retorna 1 se valida, 0 se invalida (com mensagem de erro). */
-int validar_nota(float nota) {
-    if (nota < 0.0f || nota > 10.0f) {
-        printf("[ERRO] Nota invalida: %.2f. Deve estar entre 0.0 e 10.0.\n", nota);
-        return 0;
-    }
-    return 1;
+static time_t instante_registro(const HistoricoTurma *h, uint32_t indice) {
+    const BlocoHistorico *b = h->blocos[indice / HIST_BLOCO];
+    return b->base + (time_t) b->reg[indice % HIST_BLOCO].delta_seg;
 }
 
-/* Valida se unidade (1-4) e prova (1-2) sao valores aceitos. */
-static int validar_unidade_prova(int unidade, int prova) {
-    if (unidade < 1 || unidade > 4) {
-        printf("[ERRO] Unidade invalida: %d. Deve ser entre 1 e 4.\n", unidade);
-        return 0;
-    }
-    if (prova != 1 && prova != 2) {
-        printf("[ERRO] Prova invalida: %d. Deve ser 1 ou 2.\n", prova);
-        return 0;
-    }
-    return 1;
+static const RegistroHistorico* obter_registro(const HistoricoTurma *h, uint32_t indice) {
+    return &h->blocos[indice / HIST_BLOCO]->reg[indice % HIST_BLOCO];
 }
 
-/* Struct auxiliar que guarda o estado de uma unidade antes de ser alterada.
-   E o que fica salvo na Pilha para permitir o Desfazer. */
-typedef struct {
-    Aluno  *aluno;
-    char    materia[50];
-    int     unidade;    /* indice 0-based */
-    Unidade estado;     /* copia completa antes da edicao */
-} SnapshotNota;
+/* Localiza (ou cadastra) o aluno no dicionario da turma. No cadastro, o
+   quadro atual vira o checkpoint inicial, cobrindo notas anteriores ao log. */
+static int historico_indice_aluno(HistoricoTurma *h, Aluno *a, time_t agora) {
+    for (int i = 0; i < h->qtd_alunos; i++)
+        if (strcmp(h->alunos[i].matricula, a->matricula) == 0) return i;
 
-/* Cria uma copia do estado atual da unidade e empilha com tipo "nota".
-   Deve ser chamada ANTES de qualquer alteracao. */
-static int salvar_snapshot_nota(Pilha *p, Aluno *a, char *materia, int unidade_idx) {
-    if (!p || !a) return 0;
+    if (h->qtd_alunos == UINT16_MAX) return -1;
+    if (h->qtd_alunos == h->cap_alunos) {
+        int nova_cap = h->cap_alunos ? h->cap_alunos * 2 : 8;
+        AlunoHistorico *novo = (AlunoHistorico*) realloc(h->alunos, nova_cap * sizeof(AlunoHistorico));
+        if (!novo) return -1;
+        h->alunos = novo;
+        h->cap_alunos = nova_cap;
+    }
+    AlunoHistorico *ah = &h->alunos[h->qtd_alunos];
+    memset(ah, 0, sizeof(AlunoHistorico));
+    strcpy(ah->matricula, a->matricula);
+    ah->serie = a->serie;
+    ah->ultimo = HIST_SEM_REGISTRO;
+
+    CheckpointHistorico *cp = (CheckpointHistorico*) malloc(4 * sizeof(CheckpointHistorico));
+    if (!cp) return -1;
+    ah->checkpoints = cp;
+    ah->cap_checkpoints = 4;
+    ah->qtd_checkpoints = 1;
+    cp->registro = HIST_SEM_REGISTRO;
+    cp->instante = agora;
+    cp->lacuna = 0;
     Disciplina *d = a->lista_disciplinas;
     while (d) {
-        if (strcmp(d->nome, materia) == 0) {
-            SnapshotNota *snap = (SnapshotNota*) malloc(sizeof(SnapshotNota));
-            if (!snap) return 0;
-            snap->aluno   = a;
-            snap->unidade = unidade_idx;
-            strcpy(snap->materia, materia);
-            snap->estado  = d->unidades[unidade_idx];
-            salvar_acao(p, "nota", snap);
-            return 1;
-        }
+        int idx = indice_disciplina(a->serie, d->nome);
+        if (idx >= 0) memcpy(ah->quadro[idx], d->unidades, sizeof(d->unidades));
         d = d->proximo;
     }
-    return 0;
+    memcpy(cp->quadro, ah->quadro, sizeof(ah->quadro));
+    for (int i = 0; i < MAX_DISCIPLINAS * 8; i++) ah->origem[i] = HIST_SEM_REGISTRO;
+    memcpy(cp->origem, ah->origem, sizeof(ah->origem));
+    return h->qtd_alunos++;
 }
 
-/* Restaura o estado de uma nota a partir do topo da Pilha (tipo "nota"). */
-void desfazer_nota(Pilha *p) {
-    if (!p || !p->topo) {
-        printf("[INFO] Nada para desfazer.\n");
-        return;
-    }
-    Acao *acao = p->topo;
-    if (strcmp(acao->tipo, "nota") != 0) {
-        printf("[INFO] A ultima acao na pilha nao e de nota.\n");
-        return;
+/* Indice 0 do dicionario de docentes e reservado para "sem docente". */
+static int historico_indice_docente(HistoricoTurma *h, Professor *p) {
+    if (!p) return 0;
+    for (int i = 0; i < h->qtd_docentes; i++)
+        if (strcmp(h->docentes[i], p->id) == 0) return i + 1;
+    if (h->qtd_docentes == h->cap_docentes) {
+        int nova_cap = h->cap_docentes ? h->cap_docentes * 2 : 4;
+        char (*novo)[15] = realloc(h->docentes, nova_cap * sizeof(*novo));
+        if (!novo) return 0;
+        h->docentes = novo;
+        h->cap_docentes = nova_cap;
     }
-    p->topo = acao->proximo;
-    SnapshotNota *snap = (SnapshotNota*) acao->dado;
-    Disciplina *d = snap->aluno->lista_disciplinas;
-    while (d) {
-        if (strcmp(d->nome, snap->materia) == 0) {
-            d->unidades[snap->unidade] = snap->estado;
-            printf("[UNDO] Restaurado: %s | %s | Unidade %d -> P1:%.2f P2:%.2f Media:%.2f\n",
-                   snap->aluno->nome, snap->materia, snap->unidade + 1,
-                   snap->estado.prova1, snap->estado.prova2, snap->estado.media_unidade);
-            break;
+    strcpy(h->docentes[h->qtd_docentes], p->id);
+    return ++h->qtd_docentes;
+}
+
+/* Grava o quadro corrente do aluno como checkpoint apos 'registro'. Sem
+   memoria, o checkpoint anterior fica marcado com a lacuna: as consultas
+   a partir dali falham em vez de aplicar uma cadeia incompleta, e o
+   contador segue acima de HIST_CHECKPOINT para tentar de novo no proximo
+   registro. */
+static int historico_checkpoint(AlunoHistorico *ah, uint32_t registro, time_t agora) {
+    if (ah->qtd_checkpoints == ah->cap_checkpoints) {
+        int nova_cap = ah->cap_checkpoints * 2;
+        CheckpointHistorico *novo = (CheckpointHistorico*) realloc(ah->checkpoints, nova_cap * sizeof(CheckpointHistorico));
+        if (!novo) {
+            CheckpointHistorico *ultimo = &ah->checkpoints[ah->qtd_checkpoints - 1];
+            if (!ultimo->lacuna) ultimo->lacuna = agora;
+            return 0;
         }
-        d = d->proximo;
+        ah->checkpoints = novo;
+        ah->cap_checkpoints = nova_cap;
     }
-    free(snap);
-    free(acao);
+    CheckpointHistorico *cp = &ah->checkpoints[ah->qtd_checkpoints++];
+    cp->registro = registro;
+    cp->instante = agora;
+    cp->lacuna = 0;
+    memcpy(cp->quadro, ah->quadro, sizeof(ah->quadro));
+    memcpy(cp->origem, ah->origem, sizeof(ah->origem));
+    ah->desde_checkpoint = 0;
+    return 1;
 }
 
-/* Lanca nota com validacao completa e salva snapshot para desfazer. */
-void lancar_nota_validada(Aluno *lista, Pilha *seguranca,
-                          char *mat, char *materia,
-                          int unidade, int prova, float nota) {
-    if (!validar_nota(nota))                    return;
-    if (!validar_unidade_prova(unidade, prova)) return;
-    Aluno *a = buscar_aluno(lista, mat);
-    if (!a) { printf("[ERRO] Aluno '%s' nao encontrado.\n", mat); return; }
-    salvar_snapshot_nota(seguranca, a, materia, unidade - 1);
-    lancar_nota(lista, mat, materia, unidade, prova, nota);
-    printf("[SUCESSO] Nota %.2f lancada: %s | %s | Unidade %d | Prova %d\n",
-           nota, a->nome, materia, unidade, prova);
-}
+/* Anexa um registro ao log da turma (append-only). */
+void registrar_historico_nota(Turma *t, Aluno *a, int disciplina_idx,
+                              int unidade_idx, int prova, Nota valor, Professor *docente) {
+    if (!t || !a || disciplina_idx < 0) return;
+    if (!t->historico) {
+        t->historico = (HistoricoTurma*) calloc(1, sizeof(HistoricoTurma));
+        if (!t->historico) return;
+    }
+    HistoricoTurma *h = t->historico;
 
-/* Edita uma nota ja existente com validacao e suporte a desfazer. */
-void alterar_nota(Aluno *lista, Pilha *seguranca,
-                  char *mat, char *materia,
-                  int unidade, int prova, float nova_nota) {
-    if (!validar_nota(nova_nota))               return;
-    if (!validar_unidade_prova(unidade, prova)) return;
-    Aluno *a = buscar_aluno(lista, mat);
-    if (!a) { printf("[ERRO] Aluno '%s' nao encontrado.\n", mat); return; }
-    Disciplina *d = a->lista_disciplinas;
-    while (d) {
-        if (strcmp(d->nome, materia) == 0) {
-            float antiga = (prova == 1) ? d->unidades[unidade-1].prova1
-                                        : d->unidades[unidade-1].prova2;
-            salvar_snapshot_nota(seguranca, a, materia, unidade - 1);
-            if (prova == 1) d->unidades[unidade-1].prova1 = nova_nota;
-            else            d->unidades[unidade-1].prova2 = nova_nota;
-            d->unidades[unidade-1].media_unidade =
-                (d->unidades[unidade-1].prova1 + d->unidades[unidade-1].prova2) / 2.0f;
-            printf("[SUCESSO] Nota alterada: %s | %s | U%d P%d: %.2f -> %.2f | Media: %.2f\n",
-                   a->nome, materia, unidade, prova, antiga, nova_nota,
-                   d->unidades[unidade-1].media_unidade);
-            return;
+    // Instantes sempre crescentes, para que a busca por data seja monotona
+    time_t agora = time(NULL);
+    if (agora < h->ultimo_instante) agora = h->ultimo_instante;
+    h->ultimo_instante = agora;
+
+    int ia = historico_indice_aluno(h, a, agora);
+    if (ia < 0) return;
+
+    if (h->total % HIST_BLOCO == 0) {
+        if (h->qtd_blocos == h->cap_blocos) {
+            uint32_t nova_cap = h->cap_blocos ? h->cap_blocos * 2 : 4;
+            BlocoHistorico **novo = (BlocoHistorico**) realloc(h->blocos, nova_cap * sizeof(BlocoHistorico*));
+            if (!novo) return;
+            h->blocos = novo;
+            h->cap_blocos = nova_cap;
         }
-        d = d->proximo;
+        BlocoHistorico *b = (BlocoHistorico*) malloc(sizeof(BlocoHistorico));
+        if (!b) return;
+        b->base = agora;
+        h->blocos[h->qtd_blocos++] = b;
     }
-    printf("[ERRO] Disciplina '%s' nao encontrada.\n", materia);
+
+    AlunoHistorico *ah = &h->alunos[ia];
+    uint32_t indice = h->total++;
+    BlocoHistorico *b = h->blocos[indice / HIST_BLOCO];
+    RegistroHistorico *r = &b->reg[indice % HIST_BLOCO];
+    r->delta_seg = (uint32_t)(agora - b->base);
+    r->anterior  = ah->ultimo;
+    r->aluno     = (uint16_t) ia;
+    r->docente   = (uint16_t) historico_indice_docente(h, docente);
+    r->valor     = valor;
+    r->slot      = (uint8_t)(disciplina_idx * 8 + unidade_idx * 2 + (prova - 1));
+    ah->ultimo = indice;
+
+    // Mantem o quadro corrente do aluno para gerar o proximo checkpoint
+    if (prova == 1) ah->quadro[disciplina_idx][unidade_idx].prova1 = valor;
+    else            ah->quadro[disciplina_idx][unidade_idx].prova2 = valor;
+    ah->origem[r->slot] = indice;
+
+    if (++ah->desde_checkpoint >= HIST_CHECKPOINT)
+        historico_checkpoint(ah, indice, agora);
 }
 
-/* Zera uma nota especifica e recalcula a media da unidade. */
-void remover_nota(Aluno *lista, Pilha *seguranca,
-                  char *mat, char *materia, int unidade, int prova) {
-    if (!validar_unidade_prova(unidade, prova)) return;
-    Aluno *a = buscar_aluno(lista, mat);
-    if (!a) { printf("[ERRO] Aluno '%s' nao encontrado.\n", mat); return; }
-    Disciplina *d = a->lista_disciplinas;
-    while (d) {
-        if (strcmp(d->nome, materia) == 0) {
-            salvar_snapshot_nota(seguranca, a, materia, unidade - 1);
-            if (prova == 1) d->unidades[unidade-1].prova1 = 0.0f;
-            else            d->unidades[unidade-1].prova2 = 0.0f;
-            d->unidades[unidade-1].media_unidade =
-                (d->unidades[unidade-1].prova1 + d->unidades[unidade-1].prova2) / 2.0f;
-            printf("[SUCESSO] Nota zerada: %s | %s | Unidade %d | Prova %d\n",
-                   a->nome, materia, unidade, prova);
-            return;
-        }
-        d = d->proximo;
+/* Reconstroi o quadro de notas do aluno como estava no 'instante'.
+   Retorna 0 se a matricula nao tem historico nesta turma ou se a data e
+   anterior ao primeiro registro dela, e -1 se falta o checkpoint que
+   cobriria a data (falha de memoria ao grava-lo). */
+static int reconstruir_quadro_em(const HistoricoTurma *h, const char *matricula, time_t instante,
+                                 Unidade quadro[MAX_DISCIPLINAS][4],
+                                 uint32_t origem[MAX_DISCIPLINAS * 8], int *serie) {
+    if (!h) return 0;
+    const AlunoHistorico *ah = NULL;
+    for (int i = 0; i < h->qtd_alunos; i++)
+        if (strcmp(h->alunos[i].matricula, matricula) == 0) { ah = &h->alunos[i]; break; }
+    if (!ah || ah->checkpoints[0].instante > instante) return 0;
+
+    // Busca binaria: ultimo checkpoint com instante <= data pedida
+    int ini = 0, fim = ah->qtd_checkpoints - 1;
+    while (ini < fim) {
+        int meio = (ini + fim + 1) / 2;
+        if (ah->checkpoints[meio].instante <= instante) ini = meio;
+        else fim = meio - 1;
     }
-    printf("[ERRO] Disciplina '%s' nao encontrada.\n", materia);
+    const CheckpointHistorico *cp = &ah->checkpoints[ini];
+    if (cp->lacuna && cp->lacuna <= instante) return -1;
+    memcpy(quadro, cp->quadro, sizeof(cp->quadro));
+    memcpy(origem, cp->origem, sizeof(cp->origem));
+    *serie = ah->serie;
+
+    // Registros entre este checkpoint e o proximo (no maximo HIST_CHECKPOINT)
+    uint32_t limite = (ini + 1 < ah->qtd_checkpoints) ? ah->checkpoints[ini + 1].registro : ah->ultimo;
+    uint32_t pendentes[HIST_CHECKPOINT];
+    int qtd = 0;
+    uint32_t r = limite;
+    while (r != HIST_SEM_REGISTRO && r != cp->registro && qtd < HIST_CHECKPOINT) {
+        pendentes[qtd++] = r;
+        r = obter_registro(h, r)->anterior;
+    }
+    if (r != cp->registro) return -1; // Cadeia maior que HIST_CHECKPOINT: nao aplica pela metade
+    // Aplica do mais antigo para o mais recente, parando na data pedida
+    for (int i = qtd - 1; i >= 0; i--) {
+        if (instante_registro(h, pendentes[i]) > instante) break;
+        const RegistroHistorico *reg = obter_registro(h, pendentes[i]);
+        int disc = reg->slot / 8, u = (reg->slot % 8) / 2, prova = reg->slot % 2 + 1;
+        if (prova == 1) quadro[disc][u].prova1 = reg->valor;
+        else            quadro[disc][u].prova2 = reg->valor;
+        origem[reg->slot] = pendentes[i];
+    }
+    return 1;
 }
 
-/* Exibe o quadro completo de notas de um aluno (todas as disciplinas). */
-void consultar_notas_aluno(Aluno *lista, char *mat) {
-    Aluno *a = buscar_aluno(lista, mat);
-    if (!a) { printf("[ERRO] Aluno '%s' nao encontrado.\n", mat); return; }
-    printf("\n======== QUADRO DE NOTAS: %s (%s) ========\n", a->nome, a->matricula);
-    Disciplina *d = a->lista_disciplinas;
-    while (d) {
-        printf("%-15s | ", d->nome);
+/* Consulta "como estava": exibe o quadro do aluno na data informada e,
+   para cada nota que ja havia sido lancada, quem lancou e quando. */
+void consultar_notas_aluno_em(Turma *t, char *mat, time_t instante) {
+    RASTREAR("consultar_notas_aluno_em");
+    if (!t) { printf("[ERRO] Nenhuma turma disponivel.\n"); return; }
+    Unidade quadro[MAX_DISCIPLINAS][4];
+    uint32_t origem[MAX_DISCIPLINAS * 8];
+    int serie;
+    int ok = reconstruir_quadro_em(t->historico, mat, instante, quadro, origem, &serie);
+    if (ok < 0) {
+        printf("[ERRO] Historico de '%s' na turma %s incompleto nesta data (faltou memoria).\n", mat, t->codigo);
+        return;
+    }
+    if (!ok) {
+        printf("[INFO] Sem historico de notas de '%s' na turma %s ate esta data.\n", mat, t->codigo);
+        return;
+    }
+    char data[20];
+    strftime(data, sizeof(data), "%d/%m/%Y %H:%M", localtime(&instante));
+    printf("\n======== QUADRO DE NOTAS EM %s: %s ========\n", data, mat);
+    int qtd = (serie >= 10) ? 10 : 8;
+    for (int d = 0; d < qtd; d++) {
+        printf("%-15s | ", nome_disciplina(serie, d));
         for (int i = 0; i < 4; i++) {
             printf("U%d[P1:%.1f P2:%.1f M:%.1f] ",
-                   i+1, d->unidades[i].prova1,
-                   d->unidades[i].prova2, d->unidades[i].media_unidade);
+                   i+1, nota_para_float(quadro[d][i].prova1),
+                   nota_para_float(quadro[d][i].prova2),
+                   nota_para_float(media_unidade(plano_turma(t), &quadro[d][i])));
         }
         printf("\n");
-        d = d->proximo;
+    }
+    printf("--- Autoria dos lancamentos ---\n");
+    for (int s = 0; s < MAX_DISCIPLINAS * 8; s++) {
+        if (origem[s] == HIST_SEM_REGISTRO) continue;
+        const RegistroHistorico *reg = obter_registro(t->historico, origem[s]);
+        time_t quando = instante_registro(t->historico, origem[s]);
+        strftime(data, sizeof(data), "%d/%m/%Y %H:%M", localtime(&quando));
+        printf("%-15s U%d P%d: %5.2f | por %-10s | em %s\n",
+               nome_disciplina(serie, s / 8), (s % 8) / 2 + 1, s % 2 + 1,
+               nota_para_float(reg->valor),
+               reg->docente ? t->historico->docentes[reg->docente - 1] : "N/A", data);
     }
     printf("===================================================\n");
 }
 
-/* Calcula a media geral do aluno (media das medias_final de cada disciplina).
-   Atualiza o campo media_final de cada Disciplina como efeito colateral. */
-float calcular_media_aluno(Aluno *a) {
-    if (!a) return 0.0f;
-    float soma = 0.0f;
-    int   qtd  = 0;
-    Disciplina *d = a->lista_disciplinas;
-    while (d) {
-        float su = 0.0f;
-        for (int i = 0; i < 4; i++) su += d->unidades[i].media_unidade;
-        d->media_final = su / 4.0f;
-        soma += d->media_final;
-        qtd++;
-        d = d->proximo;
-    }
-    return (qtd > 0) ? (soma / (float)qtd) : 0.0f;
+void liberar_historico(HistoricoTurma *h) {
+    if (!h) return;
+    for (uint32_t i = 0; i < h->qtd_blocos; i++) free(h->blocos[i]);
+    free(h->blocos);
+    for (int i = 0; i < h->qtd_alunos; i++) free(h->alunos[i].checkpoints);
+    free(h->alunos);
+    free(h->docentes);
+    free(h);
 }
 
-/* Fechamento da turma: percorre a lista, calcula medias e exibe
-   relatorio com Aprovados (media >= 5.0) e Reprovados. */
-void gerar_relatorio_final(Turma *t) {
-    if (!t) { printf("[ERRO] Nenhuma turma disponivel.\n"); return; }
-    if (!t->lista_alunos) {
-        printf("[AVISO] Turma %s sem alunos matriculados.\n", t->codigo);
-        return;
-    }
-    int aprovados = 0, reprovados = 0;
-    printf("\n##############################################################\n");
-    printf("##    FECHAMENTO DE NOTAS — TURMA %-10s             ##\n", t->codigo);
-    printf("##    Serie: %d | Alunos: %d / %d vagas                  ##\n",
-           t->serie, t->qtd_atual, t->limite_vagas);
-    printf("##############################################################\n");
-    Aluno *atual = t->lista_alunos;
-    while (atual != NULL) {
-        float mg = calcular_media_aluno(atual);
-        const char *status = (mg >= 5.0f) ? "APROVADO " : "REPROVADO";
-        if (mg >= 5.0f) aprovados++; else reprovados++;
-        printf("\n>> %-20s | Mat: %-12s | Media: %5.2f | [%s]\n",
-               atual->nome, atual->matricula, mg, status);
-        Disciplina *d = atual->lista_disciplinas;
-        while (d) {
-            printf("   %-15s | ", d->nome);
-            for (int i = 0; i < 4; i++)
-                printf("U%d:%.1f ", i+1, d->unidades[i].media_unidade);
-            printf("| Anual: %.2f", d->media_final);
-            if (d->media_final < 5.0f) printf(" [!]");
-            printf("\n");
-            d = d->proximo;
+/* ==========================================================================
+   2.5 ESCRITA DE NOTAS
+   ========================================================================== */
+
+/* Ponto unico de escrita de notas: grava a prova, registra no historico da
+   turma (com o docente vinculado a disciplina), publica o evento e
+   invalida os caches. */
+static void gravar_nota(Aluno *a, Disciplina *d, int unidade_idx, int prova, Nota valor) {
+    RASTREAR("gravar_nota");
+    if (prova == 1) d->unidades[unidade_idx].prova1 = valor;
+    else            d->unidades[unidade_idx].prova2 = valor;
+    reavaliar_disciplina(plano_aluno(a), d);
+    registrar_historico_nota(a->turma, a, indice_disciplina(a->serie, d->nome),
+                             unidade_idx, prova, valor, d->docente);
+    emitir_evento(EVENTO_NOTA, a->turma, a, d->nome, unidade_idx + 1, prova, valor);
+    marcar_aluno_alterado(a);
+}
+
+/* Recuperacao: fica fora do historico versionado (que guarda so as 8 provas
+   regulares) e sai no evento como unidade 5. So altera a media se o plano
+   da turma tiver 'recuperacao=menor'. */
+static void gravar_recuperacao(Aluno *a, Disciplina *d, Nota valor) {
+    d->recuperacao = valor;
+    reavaliar_disciplina(plano_aluno(a), d);
+    emitir_evento(EVENTO_NOTA, a->turma, a, d->nome, 5, 1, valor);
+    marcar_aluno_alterado(a);
+}
+
+/* ==========================================================================
+   2.6 ÍNDICE DE BUSCA POR NOME (PREFIXO, SEM ACENTO/CAIXA)
+   ========================================================================== */
+
+/* Vetor ordenado pela chave normalizada (minusculas, sem acentos): a busca
+   por prefixo e uma busca binaria pelo primeiro elemento >= prefixo seguida
+   de uma varredura enquanto a chave comecar com o prefixo. Alunos entram na
+   matricula (turma ou fila) e saem na remocao; professores no cadastro.
+   O indice e um so para a rede: a busca (buscar_por_nome, junto de Campus)
+   filtra as entradas do campus consultado. */
+
+#define BUSCA_MAX_RESULTADOS 20
+
+typedef enum { ENTRADA_ALUNO, ENTRADA_PROFESSOR } TipoEntradaNome;
+
+typedef struct {
+    char *chave;            // Nome normalizado
+    TipoEntradaNome tipo;
+    void *ref;              // Aluno* ou Professor*
+} EntradaNome;
+
+typedef struct {
+    EntradaNome *itens;
+    int qtd, cap;
+} IndiceNomes;
+
+static IndiceNomes indice_nomes = {NULL, 0, 0};
+
+/* Letra base para o segundo byte de UTF-8 0xC3 0x80..0xBF (Latin-1 acentuado).
+   '?' = simbolo sem letra equivalente, descartado. */
+static const char BASE_LATIN1[] = "aaaaaaaceeeeiiiidnooooo?ouuuuyts"
+                                  "aaaaaaaceeeeiiiidnooooo?ouuuuyty";
+
+/* Minusculas ASCII e letras acentuadas (UTF-8) reduzidas a letra base. */
+static void normalizar_nome(char *dst, size_t cap, const char *src) {
+    size_t n = 0;
+    const unsigned char *p = (const unsigned char*) src;
+    while (*p && n + 1 < cap) {
+        if (*p < 0x80) {
+            dst[n++] = (*p >= 'A' && *p <= 'Z') ? (char)(*p + 32) : (char) *p;
+            p++;
+        } else if (*p == 0xC3 && p[1] >= 0x80 && p[1] <= 0xBF) {
+            char base = BASE_LATIN1[p[1] - 0x80];
+            if (base != '?') dst[n++] = base;
+            p += 2;
+        } else {
+            p++; // Outros bytes multibyte nao tem equivalente ASCII
         }
-        printf("   ----------------------------------------------------------\n");
-        atual = atual->proximo;
     }
-    printf("\n##############################################################\n");
-    printf("##  Aprovados: %d | Reprovados: %d | Total: %d             ##\n",
-           aprovados, reprovados, aprovados + reprovados);
-    if (aprovados + reprovados > 0)
-        printf("##  Taxa de aprovacao: %.1f%%                              ##\n",
-               100.0f * aprovados / (aprovados + reprovados));
-    printf("##############################################################\n\n");
+    dst[n] = '\0';
 }
+
+/* Primeira posicao cuja chave e >= 'chave' (lower bound). */
+static int indice_limite_inferior(const char *chave) {
+    int ini = 0, fim = indice_nomes.qtd;
+    while (ini < fim) {
+        int meio = (ini + fim) / 2;
+        if (strcmp(indice_nomes.itens[meio].chave, chave) < 0) ini = meio + 1;
+        else fim = meio;
+    }
+    return ini;
+}
+
+static int indice_localizar(const char *chave, void *ref) {
+    for (int i = indice_limite_inferior(chave);
+         i < indice_nomes.qtd && strcmp(indice_nomes.itens[i].chave, chave) == 0; i++)
+        if (indice_nomes.itens[i].ref == ref) return i;
+    return -1;
+}
+
+/* Insere mantendo a ordem; ignora se o registro ja esta indexado. */
+static void indice_inserir(TipoEntradaNome tipo, void *ref, const char *nome) {
+    char chave[100];
+    normalizar_nome(chave, sizeof(chave), nome);
+    if (indice_localizar(chave, ref) >= 0) return;
+
+    if (indice_nomes.qtd == indice_nomes.cap) {
+        int nova_cap = indice_nomes.cap ? indice_nomes.cap * 2 : 64;
+        EntradaNome *novo = (EntradaNome*) realloc(indice_nomes.itens, nova_cap * sizeof(EntradaNome));
+        if (!novo) return;
+        indice_nomes.itens = novo;
+        indice_nomes.cap = nova_cap;
+    }
+    char *copia = (char*) malloc(strlen(chave) + 1);
+    if (!copia) return;
+    strcpy(copia, chave);
+
+    int pos = indice_limite_inferior(chave);
+    memmove(&indice_nomes.itens[pos + 1], &indice_nomes.itens[pos],
+            (indice_nomes.qtd - pos) * sizeof(EntradaNome));
+    indice_nomes.itens[pos].chave = copia;
+    indice_nomes.itens[pos].tipo = tipo;
+    indice_nomes.itens[pos].ref = ref;
+    indice_nomes.qtd++;
+}
+
+static int comparar_entradas_nome(const void *x, const void *y) {
+    return strcmp(((const EntradaNome*) x)->chave, ((const EntradaNome*) y)->chave);
+}
+
+/* Insercao em lote (importacao): ordena as novas entradas e intercala com o
+   vetor existente numa unica passada de tras para frente, em vez de um
+   memmove por aluno. */
+static void indice_inserir_alunos_lote(Aluno **alunos, int qtd) {
+    if (qtd <= 0) return;
+    EntradaNome *novas = (EntradaNome*) malloc(qtd * sizeof(EntradaNome));
+    if (!novas) return;
+    int m = 0;
+    for (int i = 0; i < qtd; i++) {
+        char chave[100];
+        normalizar_nome(chave, sizeof(chave), alunos[i]->nome);
+        char *copia = (char*) malloc(strlen(chave) + 1);
+        if (!copia) continue;
+        strcpy(copia, chave);
+        novas[m].chave = copia;
+        novas[m].tipo = ENTRADA_ALUNO;
+        novas[m].ref = alunos[i];
+        m++;
+    }
+    qsort(novas, m, sizeof(EntradaNome), comparar_entradas_nome);
+
+    int total = indice_nomes.qtd + m;
+    if (total > indice_nomes.cap) {
+        EntradaNome *maior = (EntradaNome*) realloc(indice_nomes.itens, total * sizeof(EntradaNome));
+        if (!maior) {
+            for (int i = 0; i < m; i++) free(novas[i].chave);
+            free(novas);
+            return;
+        }
+        indice_nomes.itens = maior;
+        indice_nomes.cap = total;
+    }
+    int i = indice_nomes.qtd - 1, j = m - 1, k = total - 1;
+    while (j >= 0) {
+        if (i >= 0 && strcmp(indice_nomes.itens[i].chave, novas[j].chave) > 0)
+            indice_nomes.itens[k--] = indice_nomes.itens[i--];
+        else
+            indice_nomes.itens[k--] = novas[j--];
+    }
+    indice_nomes.qtd = total;
+    free(novas);
+}
+
+static void indice_remover(void *ref, const char *nome) {
+    char chave[100];
+    normalizar_nome(chave, sizeof(chave), nome);
+    int pos = indice_localizar(chave, ref);
+    if (pos < 0) return;
+    free(indice_nomes.itens[pos].chave);
+    memmove(&indice_nomes.itens[pos], &indice_nomes.itens[pos + 1],
+            (indice_nomes.qtd - pos - 1) * sizeof(EntradaNome));
+    indice_nomes.qtd--;
+}
+
+void liberar_indice_nomes(void) {
+    for (int i = 0; i < indice_nomes.qtd; i++) free(indice_nomes.itens[i].chave);
+    free(indice_nomes.itens);
+    indice_nomes.itens = NULL;
+    indice_nomes.qtd = indice_nomes.cap = 0;
+}
+
+/* ==========================================================================
+   2.7 FREQUÊNCIA (BITMAPS DE PRESENÇA POR ALUNO E DISCIPLINA)
+   ========================================================================== */
+
+/* Cada Disciplina do aluno guarda dois bitsets de DIAS_LETIVOS bits: dias em
+   que houve chamada com ele na turma e dias em que esteve presente. A
+   frequência é popcount(presenca) / popcount(chamada), palavra a palavra;
+   quem entra no meio do ano só responde pelos dias em que já estava na
+   turma. Sem nenhuma chamada registrada, a regra dos 75% não se aplica. */
+
+typedef struct {
+    int aulas;                  // Dias com chamada
+    int presencas;
+} Frequencia;
+
+static int contar_bits(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int n = 0;
+    for (; x; x &= x - 1) n++;
+    return n;
+#endif
+}
+
+static int bitmap_contar(const uint64_t *v) {
+    int n = 0;
+    for (int i = 0; i < PRESENCA_PALAVRAS; i++) n += contar_bits(v[i]);
+    return n;
+}
+
+Frequencia frequencia_disciplina(const Disciplina *d) {
+    Frequencia f = {bitmap_contar(d->chamada), bitmap_contar(d->presenca)};
+    return f;
+}
+
+// Soma de todas as disciplinas (carga total, como na regra da LDB)
+Frequencia frequencia_aluno(const Aluno *a) {
+    Frequencia f = {0, 0};
+    for (const Disciplina *d = a->lista_disciplinas; d; d = d->proximo) {
+        f.aulas += bitmap_contar(d->chamada);
+        f.presencas += bitmap_contar(d->presenca);
+    }
+    return f;
+}
+
+// Frequência em milésimos (-1 se não houve chamada)
+int frequencia_milesimos(Frequencia f) {
+    return f.aulas ? (f.presencas * 1000 + f.aulas / 2) / f.aulas : -1;
+}
+
+// Média em centésimos + frequência -> Aprovado (1) / Reprovado (0), pela regra do plano
+static int situacao_final(const PlanoAvaliacao *p, int media, Frequencia f) {
+    int freq = frequencia_milesimos(f);
+    return media >= p->aprovacao && (freq < 0 || freq >= FREQUENCIA_MINIMA);
+}
+
+/* ==========================================================================
+   2.8 API DE CONSULTA E LANÇAMENTO (SEM CONSOLE)
+   ========================================================================== */
+
+/* As funções escola_* são o núcleo embutível: não escrevem em stdout,
+   devolvem um StatusEscola e preenchem estruturas fornecidas pelo chamador.
+   As telas (consultar_notas_aluno, gerar_relatorio_final, exibir_fila,
+   lancar_nota_validada, ...) apenas formatam o que elas devolvem. */
+
+typedef enum {
+    ESCOLA_OK,
+    ESCOLA_EM_FILA,                 // Turma lotada: o aluno aguarda na fila de espera
+    ESCOLA_NAO_ENCONTRADO,          // Aluno/turma inexistente
+    ESCOLA_DISCIPLINA_INEXISTENTE,
+    ESCOLA_NOTA_INVALIDA,
+    ESCOLA_UNIDADE_INVALIDA,
+    ESCOLA_PROVA_INVALIDA,
+    ESCOLA_SERIE_INVALIDA,          // Série fora de 1-12
+    ESCOLA_TURMA_VAZIA,
+    ESCOLA_JA_NA_FILA,
+    ESCOLA_CAPACIDADE_INSUFICIENTE, // Buffer do chamador pequeno; a quantidade necessária é devolvida
+    ESCOLA_SEM_MEMORIA,
+    ESCOLA_STATUS_QTD
+} StatusEscola;
+
+static const char *MENSAGENS_STATUS[] = {
+    "ok", "aluno na fila de espera", "nao encontrado", "disciplina nao encontrada",
+    "nota deve estar entre 0.0 e 10.0", "unidade deve ser entre 1 e 4", "prova deve ser 1 ou 2",
+    "serie deve ser entre 1 e 12", "turma sem alunos", "aluno ja esta na fila", "capacidade insuficiente", "sem memoria"
+};
+
+const char* escola_status_texto(StatusEscola s) {
+    return (s >= 0 && s < ESCOLA_STATUS_QTD) ? MENSAGENS_STATUS[s] : "status desconhecido";
+}
+
+// Uma linha do boletim/quadro de notas; as notas são centésimos (ver seção 2.2)
+typedef struct {
+    const char *disciplina;
+    const char *professor;      // NULL se a disciplina não tem docente vinculado
+    Nota provas[4][2];
+    Nota medias[4];             // Média de cada unidade pelo plano da turma
+    Nota recuperacao;           // 0 = não realizada
+    Nota media_final;
+    int abaixo_aprovacao;       // media_final < nota de aprovação do plano
+    Frequencia frequencia;
+} LinhaBoletim;
+
+typedef struct {
+    const Aluno *aluno;
+    int media_geral;            // Centésimos
+    int frequencia;             // Milésimos (-1 sem chamada)
+    int aprovado;
+    int qtd_disciplinas;        // Total na grade (pode passar de 'cap')
+} ResumoBoletim;
+
+/* Calcula a media geral do aluno (media das medias_final de cada disciplina),
+   em centesimos. As medias_final ja estao atualizadas pelo plano (ver
+   gravar_nota). Toda a conta e inteira: Aprovado/Reprovado e decidido sem float. */
+int calcular_media_aluno(Aluno *a) {
+    if (!a) return 0;
+    int soma = 0;
+    int qtd  = 0;
+    Disciplina *d = a->lista_disciplinas;
+    while (d) {
+        soma += d->media_final;
+        qtd++;
+        d = d->proximo;
+    }
+    return (qtd > 0) ? (soma + qtd / 2) / qtd : 0;
+}
+
+static void preencher_linha_boletim(const PlanoAvaliacao *plano, const Disciplina *d, LinhaBoletim *l) {
+    l->disciplina = d->nome;
+    l->professor = d->docente ? d->docente->nome : NULL;
+    for (int i = 0; i < 4; i++) {
+        l->provas[i][0] = d->unidades[i].prova1;
+        l->provas[i][1] = d->unidades[i].prova2;
+        l->medias[i] = (Nota) media_unidade(plano, &d->unidades[i]);
+    }
+    l->recuperacao = d->recuperacao;
+    l->media_final = d->media_final;
+    l->abaixo_aprovacao = d->media_final < plano->aprovacao;
+    l->frequencia = frequencia_disciplina(d);
+}
+
+/* Boletim completo de um aluno: até 'cap' linhas em 'linhas' (pode ser NULL
+   com cap 0 para obter só o resumo). MAX_DISCIPLINAS linhas sempre bastam. */
+StatusEscola escola_boletim(Aluno *a, LinhaBoletim *linhas, int cap, ResumoBoletim *resumo) {
+    RASTREAR("escola_boletim");
+    if (!a) return ESCOLA_NAO_ENCONTRADO;
+    const PlanoAvaliacao *plano = plano_aluno(a);
+    int n = 0;
+    for (const Disciplina *d = a->lista_disciplinas; d; d = d->proximo, n++)
+        if (n < cap) preencher_linha_boletim(plano, d, &linhas[n]);
+    if (resumo) {
+        Frequencia fr = frequencia_aluno(a);
+        resumo->aluno = a;
+        resumo->media_geral = calcular_media_aluno(a);
+        resumo->frequencia = frequencia_milesimos(fr);
+        resumo->aprovado = situacao_final(plano, resumo->media_geral, fr);
+        resumo->qtd_disciplinas = n;
+    }
+    return n > cap ? ESCOLA_CAPACIDADE_INSUFICIENTE : ESCOLA_OK;
+}
+
+// Linha do relatório de fechamento: o boletim de um aluno da turma
+typedef struct {
+    ResumoBoletim resumo;
+    LinhaBoletim disciplinas[MAX_DISCIPLINAS];
+} LinhaRelatorio;
+
+/* Iterador do fechamento de uma turma, na ordem do diário. Os totais de
+   aprovados/reprovados acumulam conforme as linhas são lidas. */
+typedef struct {
+    Turma *turma;
+    Aluno *proximo;
+    int aprovados;
+    int reprovados;
+} IteradorRelatorio;
+
+StatusEscola escola_relatorio_iniciar(Turma *t, IteradorRelatorio *it) {
+    if (!t) return ESCOLA_NAO_ENCONTRADO;
+    it->turma = t;
+    it->proximo = t->lista_alunos;
+    it->aprovados = it->reprovados = 0;
+    return t->lista_alunos ? ESCOLA_OK : ESCOLA_TURMA_VAZIA;
+}
+
+// Preenche a próxima linha; retorna 0 quando a turma acabou
+int escola_relatorio_proximo(IteradorRelatorio *it, LinhaRelatorio *linha) {
+    Aluno *a = it->proximo;
+    if (!a) return 0;
+    it->proximo = a->proximo;
+    escola_boletim(a, linha->disciplinas, MAX_DISCIPLINAS, &linha->resumo);
+    if (linha->resumo.aprovado) it->aprovados++; else it->reprovados++;
+    return 1;
+}
+
+/* ==========================================================================
+   3. GESTÃO DE PROFESSORES (CRUD & SEGURANÇA)
+   ========================================================================== */
+
+/* --- Carga docente incremental ---
+   Todo vínculo Disciplina -> Professor passa por vincular_docente, que
+   atualiza na hora os contadores do professor (turmas, encargos, alunos,
+   soma das médias) e do seu departamento; reavaliar_disciplina ajusta as
+   somas quando uma média muda. Assim listar_professores não varre alunos.
+   Invariante: um aluno só muda de turma sem vínculos (remoção, promoção). */
+
+static Departamento *departamentos = NULL; // Registro global (todos os campi)
+
+// Registro do departamento pela 1ª área do texto (sem acento/caixa); cria se faltar
+static Departamento* departamento_registrar(const char *texto) {
+    char area[50], chave[50], outra[50];
+    snprintf(area, sizeof(area), "%s", texto);
+    area[strcspn(area, ",/")] = '\0';
+    size_t n = strlen(area);
+    while (n > 0 && area[n - 1] == ' ') area[--n] = '\0';
+    normalizar_nome(chave, sizeof(chave), area);
+    for (Departamento *d = departamentos; d; d = d->proximo) {
+        normalizar_nome(outra, sizeof(outra), d->nome);
+        if (strcmp(outra, chave) == 0) return d;
+    }
+    Departamento *novo = (Departamento*) calloc(1, sizeof(Departamento));
+    if (!novo) return NULL;
+    snprintf(novo->nome, sizeof(novo->nome), "%s", area[0] ? area : "-");
+    novo->proximo = departamentos;
+    departamentos = novo;
+    return novo;
+}
+
+void liberar_departamentos(void) {
+    while (departamentos) {
+        Departamento *d = departamentos;
+        departamentos = d->proximo;
+        free(d);
+    }
+}
+
+static CargaTurma* carga_buscar(Professor *p, Turma *t, int disciplina) {
+    for (int i = 0; i < p->qtd_cargas; i++)
+        if (p->cargas[i].turma == t && p->cargas[i].disciplina == disciplina) return &p->cargas[i];
+    return NULL;
+}
+
+static int leciona_na_turma(const Professor *p, const Turma *t) {
+    for (int i = 0; i < p->qtd_cargas; i++)
+        if (p->cargas[i].turma == t) return 1;
+    return 0;
+}
+
+// Outra disciplina do mesmo aluno com o mesmo professor? (aluno distinto conta uma vez)
+static int outra_disciplina_com(const Aluno *a, const Disciplina *d, const Professor *p) {
+    for (const Disciplina *o = a->lista_disciplinas; o; o = o->proximo)
+        if (o != d && o->docente == p) return 1;
+    return 0;
+}
+
+/* Garante espaço para um encargo novo de 'p' na turma do aluno antes de
+   qualquer contador mudar (0 = sem memória). */
+static int carga_reservar(Professor *p, const Aluno *a, const Disciplina *d) {
+    if (!a->turma || p->qtd_cargas < p->cap_cargas) return 1;
+    if (carga_buscar(p, a->turma, indice_disciplina(a->turma->serie, d->nome))) return 1;
+    int nova_cap = p->cap_cargas ? p->cap_cargas * 2 : 8;
+    CargaTurma *novo = (CargaTurma*) realloc(p->cargas, nova_cap * sizeof(CargaTurma));
+    if (!novo) return 0;
+    p->cargas = novo;
+    p->cap_cargas = nova_cap;
+    return 1;
+}
+
+// Chamar só depois de carga_reservar: aqui nada falha
+static void carga_adicionar(Professor *p, Aluno *a, Disciplina *d) {
+    p->qtd_vinculos++;
+    p->soma_medias += d->media_final;
+    if (!outra_disciplina_com(a, d, p)) p->qtd_alunos++;
+    if (p->depto) {
+        p->depto->vinculos++;
+        p->depto->soma_medias += d->media_final;
+    }
+    if (!a->turma) return;
+    int k = indice_disciplina(a->turma->serie, d->nome);
+    CargaTurma *c = carga_buscar(p, a->turma, k);
+    if (c) { c->alunos++; return; }
+    if (!leciona_na_turma(p, a->turma)) p->qtd_turmas++;
+    p->cargas[p->qtd_cargas++] = (CargaTurma) {a->turma, k, 1};
+    if (p->depto) p->depto->encargos++;
+}
+
+static void carga_remover(Professor *p, Aluno *a, Disciplina *d) {
+    p->qtd_vinculos--;
+    p->soma_medias -= d->media_final;
+    if (!outra_disciplina_com(a, d, p)) p->qtd_alunos--;
+    if (p->depto) {
+        p->depto->vinculos--;
+        p->depto->soma_medias -= d->media_final;
+    }
+    if (!a->turma) return;
+    CargaTurma *c = carga_buscar(p, a->turma, indice_disciplina(a->turma->serie, d->nome));
+    if (!c || --c->alunos > 0) return;
+    *c = p->cargas[--p->qtd_cargas];
+    if (!leciona_na_turma(p, a->turma)) p->qtd_turmas--;
+    if (p->depto) p->depto->encargos--;
+}
+
+/* Ponto unico de troca do professor de uma disciplina (NULL = desvincular).
+   Sem memoria para registrar o encargo, nada muda e retorna 0: um vinculo
+   fora das cargas escaparia de remover_professor_global. */
+static int vincular_docente(Aluno *a, Disciplina *d, Professor *p) {
+    if (d->docente == p) return 1;
+    if (p && !carga_reservar(p, a, d)) return 0;
+    if (d->docente) carga_remover(d->docente, a, d);
+    d->docente = p;
+    if (p) carga_adicionar(p, a, d);
+    marcar_aluno_alterado(a);
+    return 1;
+}
+
+// Desfaz todos os vínculos do aluno (antes de ele sair da turma ou ser liberado)
+static void desvincular_docentes_aluno(Aluno *a) {
+    for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo)
+        if (d->docente) vincular_docente(a, d, NULL);
+}
+
+// Cria um professor na memória e gera seu e-mail institucional
+// (carga_maxima começa em CARGA_PADRAO; a coordenação pode ajustar depois)
+Professor* criar_professor(char *id, char *nome, char *depto) {
+    Professor *novo = (Professor*) malloc(sizeof(Professor));
+    if (!novo) return NULL;
+    strcpy(novo->id, id);
+    strcpy(novo->nome, nome);
+    strcpy(novo->departamento, depto);
+    sprintf(novo->email_funcional, "%s.%s@docente.kolping.edu.br", novo->nome, novo->id);
+    novo->carga_maxima = CARGA_PADRAO;
+    novo->depto = departamento_registrar(depto);
+    if (novo->depto) novo->depto->professores++;
+    novo->qtd_turmas = novo->qtd_alunos = novo->qtd_vinculos = 0;
+    novo->soma_medias = 0;
+    novo->cargas = NULL;
+    novo->qtd_cargas = novo->cap_cargas = 0;
+    novo->proximo = NULL;
+    return novo;
+}
+
+// Adiciona o professor no início da lista global (O(1))
+void inserir_professor_global(Professor **cabeca, Professor *novo) {
+    if (!novo) return;
+    novo->proximo = *cabeca;
+    *cabeca = novo;
+    indice_inserir(ENTRADA_PROFESSOR, novo, novo->nome);
+}
+
+// Localiza um professor pelo seu ID único
+Professor* buscar_professor(Professor *cabeca, char *id_procurado) {
+    Professor *atual = cabeca;
+    while (atual) {
+        if (strcmp(atual->id, id_procurado) == 0) return atual;
+        atual = atual->proximo;
+    }
+    return NULL;
+}
+
+// NOVO: Função de Segurança contra 'Dangling Pointers'
+// Antes de remover um professor, esta função percorre todos os alunos e limpa os vínculos
+void desvincular_professor_alunos(Aluno *lista_alunos, Professor *p_removido) {
+    Aluno *a_atual = lista_alunos;
+    while (a_atual != NULL) {
+        Disciplina *d_atual = a_atual->lista_disciplinas;
+        while (d_atual != NULL) {
+            if (d_atual->docente == p_removido)
+                vincular_docente(a_atual, d_atual, NULL); // O aluno agora está "sem professor" nesta matéria
+            d_atual = d_atual->proximo;
+        }
+        a_atual = a_atual->proximo;
+    }
+}
+
+// Remove um professor da lista global e libera a memória
+void remover_professor_global(Professor **cabeca, char *id_remover) {
+    Professor *atual = *cabeca, *anterior = NULL;
+    while (atual && strcmp(atual->id, id_remover) != 0) {
+        anterior = atual;
+        atual = atual->proximo;
+    }
+    if (!atual) return;
+    if (!anterior) *cabeca = atual->proximo;
+    else anterior->proximo = atual->proximo;
+
+    // As cargas dizem em quais turmas ele ainda tem vínculos: só essas são varridas
+    while (atual->qtd_cargas > 0)
+        desvincular_professor_alunos(atual->cargas[0].turma->lista_alunos, atual);
+    if (atual->depto) atual->depto->professores--;
+
+    printf("Sistema Kolping: Memoria do docente %s liberada.\n", atual->nome);
+    indice_remover(atual, atual->nome);
+    free(atual->cargas);
+    free(atual);
+}
+
+// Média das disciplinas vinculadas (centésimos) ou "-" sem vínculos
+static void formatar_media_carga(char *dst, size_t cap, long soma, long qtd) {
+    if (qtd > 0) snprintf(dst, cap, "%.2f", nota_para_float((int) ((soma + qtd / 2) / qtd)));
+    else snprintf(dst, cap, "-");
+}
+
+/* Carga e desempenho vêm dos contadores mantidos por vincular_docente:
+   nenhuma varredura de alunos. */
+void listar_professores(Professor *cabeca) {
+    char media[16];
+    printf("\n--- LISTA DE DOCENTES KOLPING ---\n");
+    while (cabeca) {
+        formatar_media_carga(media, sizeof(media), cabeca->soma_medias, cabeca->qtd_vinculos);
+        printf("ID: %-10s | Nome: %-20s | Depto: %-12s | Turmas: %2d | Encargos: %2d/%-2d | Alunos: %4d | Media: %s\n",
+               cabeca->id, cabeca->nome, cabeca->departamento, cabeca->qtd_turmas,
+               cabeca->qtd_cargas, cabeca->carga_maxima, cabeca->qtd_alunos, media);
+        cabeca = cabeca->proximo;
+    }
+    printf("--- DEPARTAMENTOS (todos os campi) ---\n");
+    for (Departamento *d = departamentos; d; d = d->proximo) {
+        if (d->professores == 0 && d->vinculos == 0) continue;
+        formatar_media_carga(media, sizeof(media), d->soma_medias, d->vinculos);
+        printf("%-12s | Professores: %3d | Encargos: %4d | Disciplinas de alunos: %6ld | Media: %s\n",
+               d->nome, d->professores, d->encargos, d->vinculos, media);
+    }
+}
+
+/* ==========================================================================
+   4. GESTÃO DE ALUNOS E TURMAS
+   ========================================================================== */
+
+// Matricula o aluno e já aloca todas as disciplinas baseadas na série (1-12; NULL fora disso)
+Aluno* matricular_aluno(char *matricula, char *nome, int serie) {
+    if (serie < 1 || serie > 12) return NULL;
+    Aluno *novo = (Aluno*) malloc(sizeof(Aluno));
+    if (!novo) return NULL;
+    strcpy(novo->matricula, matricula);
+    strcpy(novo->nome, nome);
+    novo->serie = serie;
+    sprintf(novo->email_academico, "%s.%s@kolping.edu.br", novo->matricula, novo->nome);
+    novo->lista_disciplinas = NULL;
+    novo->proximo = NULL;
+    novo->turma = NULL;
+    novo->versao = 1;
+    memset(&novo->cache_boletim, 0, sizeof(CacheTexto));
+    memset(&novo->cache_relatorio, 0, sizeof(CacheTexto));
+    novo->media_geral = 0;
+    novo->aprovado = 0;
+    novo->saltos = NULL;
+    novo->nivel_roster = 1;
+    novo->prioridade = PRIORIDADE_GERAL;
+    novo->chegada_fila = 0;
+    novo->posicao_fila = -1;
+
+    int qtd = (serie >= 10) ? 10 : 8;
+    const char **nomes = (serie >= 10) ? DISCIPLINAS_MEDIO : DISCIPLINAS_FUNDAMENTAL;
+
+    for (int i = 0; i < qtd; i++) {
+        Disciplina *d = (Disciplina*) malloc(sizeof(Disciplina));
+        strcpy(d->nome, nomes[i]);
+        d->docente = NULL;
+        for (int u = 0; u < 4; u++) {
+            d->unidades[u].prova1 = d->unidades[u].prova2 = 0;
+        }
+        d->media_final = 0;
+        d->recuperacao = 0;
+        memset(d->chamada, 0, sizeof(d->chamada));
+        memset(d->presenca, 0, sizeof(d->presenca));
+        d->proximo = novo->lista_disciplinas;
+        novo->lista_disciplinas = d;
+    }
+    return novo;
+}
+
+Aluno* buscar_aluno(Aluno *cabeca, char *mat) {
+    RASTREAR("buscar_aluno");
+    while (cabeca) {
+        if (strcmp(cabeca->matricula, mat) == 0) return cabeca;
+        cabeca = cabeca->proximo;
+    }
+    return NULL;
+}
+
+// Liberação de memória em cascata: Primeiro as disciplinas, depois o aluno
+void deletar_aluno(Aluno *aluno) {
+    if (!aluno) return;
+    desvincular_docentes_aluno(aluno);
+    Disciplina *atual = aluno->lista_disciplinas;
+    while (atual) {
+        Disciplina *temp = atual;
+        atual = atual->proximo;
+        free(temp);
+    }
+    indice_remover(aluno, aluno->nome);
+    free(aluno->saltos);
+    texto_liberar(&aluno->cache_boletim.texto);
+    texto_liberar(&aluno->cache_relatorio.texto);
+    free(aluno);
+}
+
+Turma* criar_turma(char *codigo, int serie, int vagas) {
+    Turma *nova = (Turma*) malloc(sizeof(Turma));
+    if (!nova) return NULL;
+    strcpy(nova->codigo, codigo);
+    nova->serie = serie;
+    nova->limite_vagas = vagas;
+    nova->qtd_atual = 0;
+    nova->professor_regente = NULL;
+    nova->lista_alunos = NULL;
+    nova->proximo_turma = NULL;
+    nova->versao = 1;
+    memset(&nova->cache_relatorio, 0, sizeof(CacheTexto));
+    nova->historico = NULL;
+    memset(nova->roster, 0, sizeof(nova->roster));
+    nova->nivel_roster = 1;
+    nova->plano = NULL;
+    return nova;
+}
+
+void inserir_turma_lista(Turma **lista_global, Turma *nova) {
+    if (!nova) return;
+    nova->proximo_turma = *lista_global;
+    *lista_global = nova;
+}
+
+// Primeira turma da lista que atende a série (NULL se nenhuma)
+Turma* buscar_turma_serie(Turma *lista, int serie) {
+    while (lista) {
+        if (lista->serie == serie) return lista;
+        lista = lista->proximo_turma;
+    }
+    return NULL;
+}
+
+// Turma da série com mais vagas livres (NULL se todas estão lotadas ou não há nenhuma)
+static Turma* turma_serie_com_vaga(Turma *lista, int serie) {
+    Turma *melhor = NULL;
+    for (; lista; lista = lista->proximo_turma) {
+        if (lista->serie != serie || lista->qtd_atual >= lista->limite_vagas) continue;
+        if (!melhor || lista->limite_vagas - lista->qtd_atual > melhor->limite_vagas - melhor->qtd_atual)
+            melhor = lista;
+    }
+    return melhor;
+}
+
+// Cria a turma "A" da série com o código padrão Kolping e a insere na lista global
+Turma* criar_turma_serie(Turma **lista_global, int serie) {
+    char codigo_turma[10];
+    if (serie == 10)
+        sprintf(codigo_turma, "1EM-A");
+    else if (serie == 11)
+        sprintf(codigo_turma, "2EM-A");
+    else if (serie == 12)
+        sprintf(codigo_turma, "3EM-A");
+    else
+        sprintf(codigo_turma, "%dANO-A", serie);
+    Turma *nova = criar_turma(codigo_turma, serie, 5);
+    inserir_turma_lista(lista_global, nova);
+    return nova;
+}
+
+/* --- Diário de classe em ordem alfabética (skip list indexável) ---
+   'lista_alunos'/'proximo' continuam sendo a lista completa da turma (nível 0),
+   agora sempre ordenada por nome (sem acento/caixa) e matrícula. Os níveis
+   superiores pulam trechos da lista e guardam quantas posições avançam, o que
+   dá inserção, remoção e acesso à k-ésima posição em O(log n) esperado.
+   Todas as entradas e saídas de turma passam por roster_inserir/roster_remover. */
+
+static uint32_t roster_semente = 0x9E3779B9u;
+
+// Altura aleatória com p = 1/4 (xorshift: determinístico entre execuções)
+static int roster_sortear_nivel(void) {
+    int nivel = 1;
+    for (;;) {
+        roster_semente ^= roster_semente << 13;
+        roster_semente ^= roster_semente >> 17;
+        roster_semente ^= roster_semente << 5;
+        if ((roster_semente & 3u) != 0 || nivel == ROSTER_NIVEIS) return nivel;
+        nivel++;
+    }
+}
+
+// Ordem do diário: nome normalizado, depois grafia original, depois matrícula
+static int roster_comparar(const Aluno *a, const Aluno *b) {
+    char ka[100], kb[100];
+    normalizar_nome(ka, sizeof(ka), a->nome);
+    normalizar_nome(kb, sizeof(kb), b->nome);
+    int c = strcmp(ka, kb);
+    if (c == 0) c = strcmp(a->nome, b->nome);
+    if (c == 0) c = strcmp(a->matricula, b->matricula);
+    return c;
+}
+
+// Enlace de nível >= 1 saindo de 'no' (NULL = cabeça da turma)
+static SaltoRoster* roster_salto(Turma *t, Aluno *no, int nivel) {
+    return no ? &no->saltos[nivel - 1] : &t->roster[nivel - 1];
+}
+
+static Aluno* roster_seguinte(Turma *t, Aluno *no, int nivel) {
+    if (nivel == 0) return no ? no->proximo : t->lista_alunos;
+    return roster_salto(t, no, nivel)->proximo;
+}
+
+static int roster_largura(Turma *t, Aluno *no, int nivel) {
+    return nivel == 0 ? 1 : roster_salto(t, no, nivel)->largura;
+}
+
+/* Último nó antes de 'a' em cada nível (anterior[]) e sua posição (pos[]). */
+static void roster_localizar(Turma *t, const Aluno *a, Aluno **anterior, int *pos) {
+    Aluno *x = NULL;
+    int p = 0;
+    for (int n = t->nivel_roster - 1; n >= 0; n--) {
+        Aluno *prox;
+        while ((prox = roster_seguinte(t, x, n)) && roster_comparar(prox, a) < 0) {
+            p += roster_largura(t, x, n);
+            x = prox;
+        }
+        anterior[n] = x;
+        pos[n] = p;
+    }
+}
+
+// Insere o aluno na posição alfabética do diário (não mexe em qtd_atual)
+static int roster_inserir(Turma *t, Aluno *a) {
+    Aluno *anterior[ROSTER_NIVEIS];
+    int pos[ROSTER_NIVEIS];
+    int nivel = roster_sortear_nivel();
+
+    SaltoRoster *saltos = NULL;
+    if (nivel > 1) {
+        saltos = (SaltoRoster*) malloc((nivel - 1) * sizeof(SaltoRoster));
+        if (!saltos) nivel = 1; // Sem torre: o nó fica só no nível 0, ainda ordenado
+    }
+    roster_localizar(t, a, anterior, pos);
+    int tamanho = t->qtd_atual;
+    for (int n = t->nivel_roster; n < nivel; n++) {
+        anterior[n] = NULL;
+        pos[n] = 0;
+        t->roster[n - 1].proximo = NULL;
+        t->roster[n - 1].largura = tamanho;
+    }
+    if (nivel > t->nivel_roster) t->nivel_roster = nivel;
+
+    free(a->saltos);
+    a->saltos = saltos;
+    a->nivel_roster = nivel;
+
+    if (anterior[0]) {
+        a->proximo = anterior[0]->proximo;
+        anterior[0]->proximo = a;
+    } else {
+        a->proximo = t->lista_alunos;
+        t->lista_alunos = a;
+    }
+    for (int n = 1; n < nivel; n++) {
+        SaltoRoster *s = roster_salto(t, anterior[n], n);
+        int avanco = pos[0] - pos[n];
+        a->saltos[n - 1].proximo = s->proximo;
+        a->saltos[n - 1].largura = s->largura - avanco;
+        s->proximo = a;
+        s->largura = avanco + 1;
+    }
+    for (int n = nivel; n < t->nivel_roster; n++)
+        roster_salto(t, anterior[n], n)->largura++;
+    return pos[0] + 1;
+}
+
+// Retira o aluno do diário e libera sua torre (não mexe em qtd_atual)
+static void roster_remover(Turma *t, Aluno *a) {
+    Aluno *anterior[ROSTER_NIVEIS];
+    int pos[ROSTER_NIVEIS];
+    roster_localizar(t, a, anterior, pos);
+    if (roster_seguinte(t, anterior[0], 0) != a) return;
+
+    if (anterior[0]) anterior[0]->proximo = a->proximo;
+    else t->lista_alunos = a->proximo;
+    for (int n = 1; n < t->nivel_roster; n++) {
+        SaltoRoster *s = roster_salto(t, anterior[n], n);
+        if (s->proximo == a) {
+            s->proximo = a->saltos[n - 1].proximo;
+            s->largura += a->saltos[n - 1].largura - 1;
+        } else {
+            s->largura--;
+        }
+    }
+    while (t->nivel_roster > 1 && !t->roster[t->nivel_roster - 2].proximo)
+        t->nivel_roster--;
+
+    free(a->saltos);
+    a->saltos = NULL;
+    a->nivel_roster = 1;
+    a->proximo = NULL;
+}
+
+// Esvazia o diário da turma (os alunos continuam vivos; só as torres são liberadas)
+static void roster_esvaziar(Turma *t) {
+    for (Aluno *a = t->lista_alunos; a; a = a->proximo) {
+        free(a->saltos);
+        a->saltos = NULL;
+        a->nivel_roster = 1;
+    }
+    t->lista_alunos = NULL;
+    memset(t->roster, 0, sizeof(t->roster));
+    t->nivel_roster = 1;
+}
+
+// Aluno na posição 'posicao' do diário (1 = primeiro), NULL se fora da faixa
+Aluno* roster_posicao(Turma *t, int posicao) {
+    if (!t || posicao < 1 || posicao > t->qtd_atual) return NULL;
+    Aluno *x = NULL;
+    int p = 0;
+    for (int n = t->nivel_roster - 1; n >= 0; n--) {
+        Aluno *prox;
+        while ((prox = roster_seguinte(t, x, n)) && p + roster_largura(t, x, n) <= posicao) {
+            p += roster_largura(t, x, n);
+            x = prox;
+        }
+        if (p == posicao) return x;
+    }
+    return NULL;
+}
+
+#define DIARIO_POR_PAGINA 30
+
+// Imprime a página 'pagina' (1 = primeira) do diário oficial da turma
+void exibir_pagina_diario(Turma *t, int pagina) {
+    if (!t || t->qtd_atual == 0) {
+        printf("\nTurma sem alunos matriculados.\n");
+        return;
+    }
+    int paginas = (t->qtd_atual + DIARIO_POR_PAGINA - 1) / DIARIO_POR_PAGINA;
+    if (pagina < 1 || pagina > paginas) {
+        printf("ERRO: Pagina invalida (1 a %d).\n", paginas);
+        return;
+    }
+    int primeiro = (pagina - 1) * DIARIO_POR_PAGINA + 1;
+    printf("\n--- DIARIO DE CLASSE %s | Pagina %d/%d ---\n", t->codigo, pagina, paginas);
+    Aluno *a = roster_posicao(t, primeiro);
+    for (int n = primeiro; a && n < primeiro + DIARIO_POR_PAGINA; n++, a = a->proximo)
+        printf("%3d. %-30s | Mat: %s\n", n, a->nome, a->matricula);
+}
+
+// Liga o aluno à turma (sem checar vagas nem indexar o nome)
+static void anexar_aluno_turma(Turma *t, Aluno *a) {
+    roster_inserir(t, a);
+    t->qtd_atual++;
+    a->turma = t;
+    reavaliar_aluno(a); // A turma pode ter outra regra de avaliação
+    marcar_turma_alterada(t);
+    emitir_evento(EVENTO_MATRICULA, t, a, NULL, 0, 0, 0);
+}
+
+// Adiciona aluno na turma respeitando o limite físico de vagas
+void vincular_aluno_turma(Turma *t, Aluno *a) {
+    RASTREAR("vincular_aluno_turma");
+    if (t->qtd_atual >= t->limite_vagas) {
+        printf("ALERTA: Turma %s lotada! %s deve aguardar vaga.\n", t->codigo, a->nome);
+        return;
+    }
+    anexar_aluno_turma(t, a);
+    indice_inserir(ENTRADA_ALUNO, a, a->nome);
+}
+
+/* ==========================================================================
+   5. OPERAÇÕES ACADÊMICAS (PORTAL DO DOCENTE)
+   ========================================================================== */
+
+// Vincula um professor da lista global a uma disciplina específica de um aluno (1 = vinculado)
+int atribuir_professor(Aluno *a, char *nome_materia, Professor *p) {
+    if (!a || !p) return 0;
+    Disciplina *atual = a->lista_disciplinas;
+    while (atual != NULL) {
+        if (strcmp(atual->nome, nome_materia) == 0)
+            return vincular_docente(a, atual, p);
+        atual = atual->proximo;
+    }
+    return 0;
+}
+
+// Percorre as disciplinas e monta o boletim (médias finais e professores vinculados)
+static void renderizar_boletim(Aluno *a) {
+    Texto *tx = &a->cache_boletim.texto;
+    texto_limpar(tx);
+    texto_printf(tx, "\n========= BOLETIM KOLPING: %s (%s) =========\n", a->nome, a->matricula);
+    LinhaBoletim linhas[MAX_DISCIPLINAS];
+    ResumoBoletim resumo;
+    escola_boletim(a, linhas, MAX_DISCIPLINAS, &resumo);
+    for (int i = 0; i < resumo.qtd_disciplinas && i < MAX_DISCIPLINAS; i++) {
+        texto_printf(tx, "- %-15s | Media Final: %.2f | Prof: %s", linhas[i].disciplina,
+                nota_para_float(linhas[i].media_final), linhas[i].professor ? linhas[i].professor : "N/A");
+        int freq = frequencia_milesimos(linhas[i].frequencia);
+        if (freq >= 0) texto_printf(tx, " | Freq: %.1f%%", freq / 10.0);
+        texto_printf(tx, "\n");
+    }
+    texto_printf(tx, "======================================================\n");
+    a->cache_boletim.versao = a->versao;
+}
+
+// Exibe o boletim, reaproveitando a última renderização se nada mudou
+void exibir_boletim(Aluno *a) {
+    RASTREAR("exibir_boletim");
+    if (!a) return;
+    if (!cache_valido(&a->cache_boletim, a->versao)) renderizar_boletim(a);
+    fputs(texto_conteudo(&a->cache_boletim.texto), stdout);
+}
+
+
+
+/* ==========================================================================
+FILA DE ESPERA E CONTROLE DE VAGAS
+   ========================================================================== */
+
+// 1. ESTRUTURA DA FILA
+// Uma fila por série, cada uma um heap binário indexado: o topo é o aluno de
+// maior prioridade (classe, depois ordem de chegada). O próprio Aluno guarda
+// sua posição no heap ('posicao_fila'), e uma tabela hash matrícula -> Aluno
+// localiza qualquer candidato; entrar, sair, mudar de prioridade e desistir
+// custam O(log n). O ponteiro "proximo" do aluno continua livre.
+#define FILA_SERIES 13              // Índice = série (1-12)
+_Static_assert(FILA_SERIES > 12, "a fila precisa de um heap para cada serie de 1 a 12");
+
+// Falhas de inserir_fila (retornos negativos)
+#define FILA_ERRO_SERIE     (-1)    // Série fora de 1-12
+#define FILA_ERRO_REPETIDO  (-2)    // Aluno já está na fila
+#define FILA_ERRO_MEMORIA   (-3)
+
+typedef struct {
+    Aluno **itens;
+    int qtd, cap;
+} HeapFila;
+
+typedef struct FilaEspera {
+    HeapFila series[FILA_SERIES];
+    Aluno **mapa;                   // Matrícula -> aluno na fila (endereçamento aberto)
+    size_t mascara;                 // Capacidade do mapa - 1
+    int ocupados;
+    unsigned long chegadas;         // Contador de chegada (desempate FIFO)
+    int quantidade;
+} FilaEspera;
+
+static size_t hash_matricula(const char *s, size_t tam) {
+    size_t h = 1469598103934665603ULL; // FNV-1a
+    for (size_t i = 0; i < tam; i++) { h ^= (unsigned char) s[i]; h *= 1099511628211ULL; }
+    return h;
+}
+
+// 2. FUNÇÕES INTERNAS (HEAP E MAPA)
+
+// 'a' deve sair antes de 'b'?
+static int fila_antes(const Aluno *a, const Aluno *b) {
+    if (a->prioridade != b->prioridade) return a->prioridade < b->prioridade;
+    return a->chegada_fila < b->chegada_fila;
+}
+
+static void heap_colocar(HeapFila *h, int i, Aluno *a) {
+    h->itens[i] = a;
+    a->posicao_fila = i;
+}
+
+static void heap_subir(HeapFila *h, int i) {
+    Aluno *a = h->itens[i];
+    while (i > 0) {
+        int pai = (i - 1) / 2;
+        if (!fila_antes(a, h->itens[pai])) break;
+        heap_colocar(h, i, h->itens[pai]);
+        i = pai;
+    }
+    heap_colocar(h, i, a);
+}
+
+static void heap_descer(HeapFila *h, int i) {
+    Aluno *a = h->itens[i];
+    for (;;) {
+        int filho = 2 * i + 1;
+        if (filho >= h->qtd) break;
+        if (filho + 1 < h->qtd && fila_antes(h->itens[filho + 1], h->itens[filho])) filho++;
+        if (!fila_antes(h->itens[filho], a)) break;
+        heap_colocar(h, i, h->itens[filho]);
+        i = filho;
+    }
+    heap_colocar(h, i, a);
+}
+
+static size_t fila_mapa_slot(const FilaEspera *f, const char *mat) {
+    size_t i = hash_matricula(mat, strlen(mat)) & f->mascara;
+    while (f->mapa[i] && strcmp(f->mapa[i]->matricula, mat) != 0)
+        i = (i + 1) & f->mascara;
+    return i;
+}
+
+static int fila_mapa_crescer(FilaEspera *f) {
+    size_t cap = f->mapa ? (f->mascara + 1) * 2 : 64;
+    Aluno **antigo = f->mapa;
+    size_t cap_antiga = f->mapa ? f->mascara + 1 : 0;
+    Aluno **novo = (Aluno**) calloc(cap, sizeof(Aluno*));
+    if (!novo) return 0;
+    f->mapa = novo;
+    f->mascara = cap - 1;
+    for (size_t i = 0; i < cap_antiga; i++)
+        if (antigo[i]) f->mapa[fila_mapa_slot(f, antigo[i]->matricula)] = antigo[i];
+    free(antigo);
+    return 1;
+}
+
+// Remoção com deslocamento para trás (mantém as sondagens sem lápides)
+static void fila_mapa_remover(FilaEspera *f, const Aluno *a) {
+    size_t i = fila_mapa_slot(f, a->matricula);
+    if (f->mapa[i] != a) return;
+    f->mapa[i] = NULL;
+    f->ocupados--;
+    for (size_t j = (i + 1) & f->mascara; f->mapa[j]; j = (j + 1) & f->mascara) {
+        size_t k = hash_matricula(f->mapa[j]->matricula, strlen(f->mapa[j]->matricula)) & f->mascara;
+        // O item em j pode ocupar o buraco i se seu slot ideal k não estiver em (i, j]
+        int preso = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+        if (!preso) {
+            f->mapa[i] = f->mapa[j];
+            f->mapa[j] = NULL;
+            i = j;
+        }
+    }
+}
+
+// Tira o item 'i' do heap da série e do mapa; retorna o aluno
+static Aluno* fila_extrair(FilaEspera *f, int serie, int i) {
+    HeapFila *h = &f->series[serie];
+    Aluno *a = h->itens[i];
+    h->qtd--;
+    if (i < h->qtd) {
+        Aluno *movido = h->itens[h->qtd]; // O último ocupa o buraco e se acomoda
+        heap_colocar(h, i, movido);
+        heap_descer(h, i);
+        heap_subir(h, movido->posicao_fila);
+    }
+    a->posicao_fila = -1;
+    fila_mapa_remover(f, a);
+    f->quantidade--;
+    emitir_evento(EVENTO_FILA_SAIDA, NULL, a, NULL, serie, a->prioridade, h->qtd);
+    return a;
+}
+
+// 3. FUNÇÕES BÁSICAS DA FILA (CRUD DA FILA)
+
+FilaEspera* criar_fila() {
+    FilaEspera *f = (FilaEspera*) calloc(1, sizeof(FilaEspera));
+    return f;
+}
+
+// Insere o aluno na fila da sua série sem mensagens; retorna quantos aguardam
+// nessa série, ou um FILA_ERRO_* (negativo)
+static int inserir_fila(FilaEspera *f, Aluno *a) {
+    RASTREAR("inserir_fila");
+    if (!f || !a || a->serie < 1 || a->serie >= FILA_SERIES) return FILA_ERRO_SERIE;
+    if (a->posicao_fila >= 0) return FILA_ERRO_REPETIDO;
+    if ((size_t) (f->ocupados + 1) * 2 > (f->mapa ? f->mascara + 1 : 0) && !fila_mapa_crescer(f))
+        return FILA_ERRO_MEMORIA;
+
+    HeapFila *h = &f->series[a->serie];
+    if (h->qtd == h->cap) {
+        int nova_cap = h->cap ? h->cap * 2 : 16;
+        Aluno **novo = (Aluno**) realloc(h->itens, nova_cap * sizeof(Aluno*));
+        if (!novo) return FILA_ERRO_MEMORIA;
+        h->itens = novo;
+        h->cap = nova_cap;
+    }
+    a->chegada_fila = ++f->chegadas;
+    heap_colocar(h, h->qtd++, a);
+    heap_subir(h, h->qtd - 1);
+    f->mapa[fila_mapa_slot(f, a->matricula)] = a;
+    f->ocupados++;
+    f->quantidade++;
+    emitir_evento(EVENTO_FILA_ENTRADA, NULL, a, NULL, a->serie, a->prioridade, h->qtd);
+    return h->qtd;
+}
+
+// Insere na fila sem mensagens; 'aguardando' (opcional) recebe o tamanho da fila da série
+StatusEscola escola_enfileirar(FilaEspera *f, Aluno *a, int *aguardando) {
+    if (!f || !a) return ESCOLA_NAO_ENCONTRADO;
+    int qtd = inserir_fila(f, a);
+    if (aguardando) *aguardando = qtd > 0 ? qtd : 0;
+    switch (qtd) {
+    case FILA_ERRO_SERIE:    return ESCOLA_SERIE_INVALIDA;
+    case FILA_ERRO_REPETIDO: return ESCOLA_JA_NA_FILA;
+    case FILA_ERRO_MEMORIA:  return ESCOLA_SEM_MEMORIA;
+    default:                 return ESCOLA_OK;
+    }
+}
+
+// Push/Enqueue - Insere o aluno na fila de espera da sua série
+void enfileirar(FilaEspera *f, Aluno *a) {
+    int aguardando;
+    StatusEscola st = escola_enfileirar(f, a, &aguardando);
+    if (st == ESCOLA_OK)
+        printf("FILA: %s adicionado a fila de espera da %da serie (Prioridade: %s, %d aguardando).\n",
+               a->nome, a->serie, NOMES_PRIORIDADE[a->prioridade], aguardando);
+    else if (a)
+        printf("[ERRO] %s nao entrou na fila de espera: %s.\n", a->nome, escola_status_texto(st));
+}
+
+// Retira o candidato de maior prioridade da série (NULL se não há ninguém)
+Aluno* desenfileirar_serie(FilaEspera *f, int serie) {
+    RASTREAR("desenfileirar_serie");
+    if (!f || serie < 1 || serie >= FILA_SERIES || f->series[serie].qtd == 0) return NULL;
+    return fila_extrair(f, serie, 0);
+}
+
+// Pop/Dequeue - Retira o candidato de maior prioridade entre todas as séries
+Aluno* desenfileirar(FilaEspera *f) {
+    RASTREAR("desenfileirar");
+    if (!f || f->quantidade == 0) return NULL; // Fila vazia
+    int melhor = 0;
+    for (int s = 1; s < FILA_SERIES; s++) {
+        if (f->series[s].qtd == 0) continue;
+        if (!melhor || fila_antes(f->series[s].itens[0], f->series[melhor].itens[0])) melhor = s;
+    }
+    return fila_extrair(f, melhor, 0);
+}
+
+Aluno* buscar_fila(FilaEspera *f, const char *matricula) {
+    RASTREAR("buscar_fila");
+    if (!f || !f->mapa) return NULL;
+    return f->mapa[fila_mapa_slot(f, matricula)];
+}
+
+// Desistência: retira o aluno da fila pela matrícula (o aluno continua vivo)
+Aluno* retirar_fila(FilaEspera *f, const char *matricula) {
+    RASTREAR("retirar_fila");
+    Aluno *a = buscar_fila(f, matricula);
+    if (!a) return NULL;
+    return fila_extrair(f, a->serie, a->posicao_fila);
+}
+
+// Troca a classe de prioridade mantendo a ordem de chegada original
+int alterar_prioridade_fila(FilaEspera *f, const char *matricula, PrioridadeFila nova) {
+    RASTREAR("alterar_prioridade_fila");
+    Aluno *a = buscar_fila(f, matricula);
+    if (!a || nova < 0 || nova >= PRIORIDADE_CLASSES) return 0;
+    PrioridadeFila antiga = a->prioridade;
+    a->prioridade = nova;
+    HeapFila *h = &f->series[a->serie];
+    if (nova < antiga) heap_subir(h, a->posicao_fila);
+    else heap_descer(h, a->posicao_fila);
+    return 1;
+}
+
+// Libera a estrutura da fila (os alunos que ainda aguardam não são liberados)
+void liberar_fila(FilaEspera *f) {
+    if (!f) return;
+    for (int s = 0; s < FILA_SERIES; s++) {
+        for (int i = 0; i < f->series[s].qtd; i++) f->series[s].itens[i]->posicao_fila = -1;
+        free(f->series[s].itens);
+    }
+    free(f->mapa);
+    free(f);
+}
+
+// Um candidato da fila, já com sua colocação dentro da série
+typedef struct {
+    Aluno *aluno;
+    int serie;
+    int lugar;                  // 1 = próximo a ser chamado na série
+    PrioridadeFila prioridade;
+} EntradaFila;
+
+static int comparar_fila(const void *x, const void *y) {
+    const EntradaFila *a = (const EntradaFila*) x, *b = (const EntradaFila*) y;
+    if (a->serie != b->serie) return a->serie - b->serie;
+    return fila_antes(a->aluno, b->aluno) ? -1 : (fila_antes(b->aluno, a->aluno) ? 1 : 0);
+}
+
+/* Lista a fila na ordem de atendimento (por série) dentro do buffer do
+   chamador. serie 0 = todas. Em *qtd vem o número de candidatos; se passar
+   de 'cap', nada é escrito e o status é ESCOLA_CAPACIDADE_INSUFICIENTE. */
+StatusEscola escola_fila_listar(FilaEspera *f, int serie, EntradaFila *saida, int cap, int *qtd) {
+    RASTREAR("escola_fila_listar");
+    *qtd = 0;
+    if (!f) return ESCOLA_NAO_ENCONTRADO;
+    if (serie < 0 || serie >= FILA_SERIES) return ESCOLA_SERIE_INVALIDA;
+    int de = serie ? serie : 1, ate = serie ? serie : FILA_SERIES - 1;
+    int total = 0;
+    for (int s = de; s <= ate; s++) total += f->series[s].qtd;
+    *qtd = total;
+    if (total > cap) return ESCOLA_CAPACIDADE_INSUFICIENTE;
+
+    // O heap só garante o topo: copia e ordena para ter a ordem completa
+    int n = 0;
+    for (int s = de; s <= ate; s++)
+        for (int i = 0; i < f->series[s].qtd; i++) {
+            Aluno *a = f->series[s].itens[i];
+            EntradaFila e = {a, s, 0, a->prioridade};
+            saida[n++] = e;
+        }
+    qsort(saida, n, sizeof(EntradaFila), comparar_fila);
+    for (int i = 0; i < n; i++)
+        saida[i].lugar = (i > 0 && saida[i - 1].serie == saida[i].serie) ? saida[i - 1].lugar + 1 : 1;
+    return ESCOLA_OK;
+}
+
+void exibir_fila(FilaEspera *f) {
+    if (!f || f->quantidade == 0) {
+        printf("\n[ Fila de Espera Vazia ]\n");
+        return;
+    }
+    EntradaFila *ordem = (EntradaFila*) malloc(f->quantidade * sizeof(EntradaFila));
+    if (!ordem) return;
+    int qtd;
+    escola_fila_listar(f, 0, ordem, f->quantidade, &qtd);
+    printf("\n--- FILA DE ESPERA (%d alunos aguardando) ---\n", qtd);
+    for (int i = 0; i < qtd; i++) {
+        if (ordem[i].lugar == 1) printf("%da serie:\n", ordem[i].serie);
+        printf("  %dº lugar - Nome: %-20s | Mat: %-10s | Prioridade: %s\n", ordem[i].lugar,
+               ordem[i].aluno->nome, ordem[i].aluno->matricula, NOMES_PRIORIDADE[ordem[i].prioridade]);
+    }
+    free(ordem);
+}
+
+/* Decide se o aluno entra na Turma ou vai para a Fila, sem mensagens:
+   ESCOLA_OK (matriculado) ou ESCOLA_EM_FILA ('aguardando' recebe o tamanho
+   da fila da série). */
+StatusEscola escola_matricular_turma(Turma *t, Aluno *a, FilaEspera *f, int *aguardando) {
+    RASTREAR("escola_matricular_turma");
+    if (!t || !a) return ESCOLA_NAO_ENCONTRADO;
+    indice_inserir(ENTRADA_ALUNO, a, a->nome); // Localizável pelo nome já na fila
+    if (t->qtd_atual < t->limite_vagas) {
+        // Inserção na Lista Encadeada (Turma)
+        anexar_aluno_turma(t, a);
+        return ESCOLA_OK;
+    }
+    // Lotação atingida: vai para a Fila (Integrante 2 atua)
+    StatusEscola st = escola_enfileirar(f, a, aguardando);
+    return st == ESCOLA_OK ? ESCOLA_EM_FILA : st;
+}
+
+void processar_matricula_turma(Turma *t, Aluno *a, FilaEspera *f) {
+    int aguardando = 0;
+    StatusEscola st = escola_matricular_turma(t, a, f, &aguardando);
+    if (st == ESCOLA_OK)
+        printf("SUCESSO: %s matriculado na turma %s.\n", a->nome, t->codigo);
+    else if (st == ESCOLA_EM_FILA)
+        printf("ALERTA: Turma %s lotada! FILA: %s adicionado a fila de espera da %da serie (Prioridade: %s, %d aguardando).\n",
+               t->codigo, a->nome, a->serie, NOMES_PRIORIDADE[a->prioridade], aguardando);
+    else
+        printf("[ERRO] Matricula de %s: %s.\n", a ? a->nome : "?", escola_status_texto(st));
+}
+
+// Função de remover da turma que puxa automaticamente o próximo da fila
+void remover_aluno_turma(Turma *t, char *matricula, FilaEspera *f) {
+    RASTREAR("remover_aluno_turma");
+    if (!t || !t->lista_alunos) return;
+
+    Aluno *atual = t->lista_alunos;
+    while (atual != NULL && strcmp(atual->matricula, matricula) != 0)
+        atual = atual->proximo;
+
+    if (atual == NULL) {
+        printf("ERRO: Aluno %s nao encontrado.\n", matricula);
+        return;
+    }
+
+    // Remove do diário (mantém a ordem alfabética dos demais)
+    roster_remover(t, atual);
+    t->qtd_atual--;
+    desvincular_docentes_aluno(atual); // Os contadores dos professores são por turma
+    atual->turma = NULL;
+    marcar_turma_alterada(t);
+    emitir_evento(EVENTO_REMOCAO, t, atual, NULL, 0, 0, 0);
+    indice_remover(atual, atual->nome);
+    printf("AVISO: %s foi removido da turma %s. Uma vaga abriu!\n", atual->nome, t->codigo);
+
+    // Automação: Puxa o candidato de maior prioridade da mesma série
+    if (f->quantidade > 0) {
+        Aluno *promovido = desenfileirar_serie(f, t->serie);
+        if (promovido) {
+            printf(">> SISTEMA: Promovendo o proximo da fila de espera...\n");
+            processar_matricula_turma(t, promovido, f); 
+        }
+    }
+}
+
+/* ============================================================
+   ESTRUTURA PILHA (DESFAZER AÇÕES)
+   ============================================================ */
+
+// Cada ação representa uma operação que pode ser desfeita
+typedef struct Acao {
+    char tipo[20];       // Tipo da ação: "nota", "professor_removido", "aluno_removido"
+    void *dado;          // Ponteiro genérico para o dado que será restaurado
+    struct Acao *proximo; 
+} Acao;
+
+// Pilha que mantém o topo das ações salvas
+typedef struct Pilha {
+    Acao *topo;           
+} Pilha;
+
+// Função para criar uma pilha vazia
+Pilha* criarPilha() {
+    Pilha *p = (Pilha*) malloc(sizeof(Pilha)); 
+    if (!p) return NULL;                       
+    p->topo = NULL;                             // Inicialmente, a pilha está vazia
+    return p;
+}
+
+// Função para salvar uma ação na pilha antes de qualquer alteração
+void salvar_acao(Pilha *p, char *tipo, void *dado) {
+    if (!p || !tipo || !dado) return;          
+
+    Acao *novo = (Acao*) malloc(sizeof(Acao)); 
+    strcpy(novo->tipo, tipo);                  // Copia o tipo da ação
+    novo->dado = dado;                         // Salva o ponteiro para o dado
+    novo->proximo = p->topo;                   // Faz o novo apontar para o topo atual
+    p->topo = novo;                            // Atualiza o topo da pilha para o novo nó
+}
+
+// Função para desfazer a última ação
+void desfazer(Pilha *p) {
+    if (!p || !p->topo) {                      
+        printf("Nada para desfazer!\n");
+        return;
+    }
+
+    Acao *a = p->topo;                         // Pega a ação do topo
+    p->topo = a->proximo;                       // Atualiza o topo para o próximo
+
+    // Dependendo do tipo, restaura-se o estado antigo
+    if (strcmp(a->tipo, "nota") == 0) {
+        Unidade *u = (Unidade*) a->dado;       // Recupera a unidade antiga
+        
+    } 
+    else if (strcmp(a->tipo, "professor_removido") == 0) {
+        Professor *p_restaurar = (Professor*) a->dado;
+        // Reinsere o professor removido na lista global
+    } 
+    else if (strcmp(a->tipo, "aluno_removido") == 0) {
+        Aluno *a_restaurar = (Aluno*) a->dado;
+        // Reinsere o aluno removido na lista da turma
+    }
+
+    free(a);                                   // Libera a memória do nó da pilha 
+}
+
+/* ============================================================
+   ESTRUTURA PILHA PARA HISTÓRICO DE MENUS
+   ============================================================ */
+
+// Cada nó representa uma tela/menu visitado
+typedef struct Menu {
+    int id_menu;          
+    struct Menu *proximo; 
+} Menu;
+
+
+Menu *menu_topo = NULL;
+
+// Empilha ao entrar em um menu
+void entrar_menu(int id) {
+    Menu *novo = malloc(sizeof(Menu));  
+    if (!novo) return;                  
+    novo->id_menu = id;                 // Guarda o ID do menu
+    novo->proximo = menu_topo;          // Aponta para o menu anterior (topo atual)
+    menu_topo = novo;                   // Atualiza o topo da pilha
+}
+
+// Desempilha ao voltar para o menu anterior
+int voltar_menu() {
+    if (!menu_topo) return -1;          // Se pilha vazia, retorna -1 (nenhum menu anterior)
+
+    Menu *temp = menu_topo;             // Guarda o topo atual
+    menu_topo = menu_topo->proximo;     // Atualiza o topo para o próximo da pilha
+    int id = temp->id_menu;             // Recupera o ID do menu a retornar
+    free(temp);                         // Libera a memória do nó desempilhado
+    return id;                          // Retorna o ID do menu anterior
+}
+
+/* Valida se a nota esta entre 0.0 e 10.0.
+   Retorna 1 se valida, 0 se invalida (com mensagem de erro). */
+int validar_nota(float nota) {
+    if (nota < 0.0f || nota > 10.0f) {
+        printf("[ERRO] Nota invalida: %.2f. Deve estar entre 0.0 e 10.0.\n", nota);
+        return 0;
+    }
+    return 1;
+}
+
+/* Valida se unidade (1-4) e prova (1-2) sao valores aceitos. */
+static StatusEscola checar_unidade_prova(int unidade, int prova) {
+    if (unidade < 1 || unidade > 4) return ESCOLA_UNIDADE_INVALIDA;
+    if (prova != 1 && prova != 2)   return ESCOLA_PROVA_INVALIDA;
+    return ESCOLA_OK;
+}
+
+/* Struct auxiliar que guarda o estado de uma unidade antes de ser alterada.
+   E o que fica salvo na Pilha para permitir o Desfazer. */
+typedef struct {
+    Aluno  *aluno;
+    char    materia[50];
+    int     unidade;    /* indice 0-based */
+    Unidade estado;     /* copia completa antes da edicao */
+} SnapshotNota;
+
+/* Cria uma copia do estado atual da unidade e empilha com tipo "nota".
+   Deve ser chamada ANTES de qualquer alteracao. */
+static int salvar_snapshot_nota(Pilha *p, Aluno *a, char *materia, int unidade_idx) {
+    if (!p || !a) return 0;
+    Disciplina *d = a->lista_disciplinas;
+    while (d) {
+        if (strcmp(d->nome, materia) == 0) {
+            SnapshotNota *snap = (SnapshotNota*) malloc(sizeof(SnapshotNota));
+            if (!snap) return 0;
+            snap->aluno   = a;
+            snap->unidade = unidade_idx;
+            strcpy(snap->materia, materia);
+            snap->estado  = d->unidades[unidade_idx];
+            salvar_acao(p, "nota", snap);
+            return 1;
+        }
+        d = d->proximo;
+    }
+    return 0;
+}
+
+/* Restaura o estado de uma nota a partir do topo da Pilha (tipo "nota"). */
+void desfazer_nota(Pilha *p) {
+    RASTREAR("desfazer_nota");
+    if (!p || !p->topo) {
+        printf("[INFO] Nada para desfazer.\n");
+        return;
+    }
+    Acao *acao = p->topo;
+    if (strcmp(acao->tipo, "nota") != 0) {
+        printf("[INFO] A ultima acao na pilha nao e de nota.\n");
+        return;
+    }
+    p->topo = acao->proximo;
+    SnapshotNota *snap = (SnapshotNota*) acao->dado;
+    Disciplina *d = snap->aluno->lista_disciplinas;
+    while (d) {
+        if (strcmp(d->nome, snap->materia) == 0) {
+            if (d->unidades[snap->unidade].prova1 != snap->estado.prova1)
+                gravar_nota(snap->aluno, d, snap->unidade, 1, snap->estado.prova1);
+            if (d->unidades[snap->unidade].prova2 != snap->estado.prova2)
+                gravar_nota(snap->aluno, d, snap->unidade, 2, snap->estado.prova2);
+            printf("[UNDO] Restaurado: %s | %s | Unidade %d -> P1:%.2f P2:%.2f Media:%.2f\n",
+                   snap->aluno->nome, snap->materia, snap->unidade + 1,
+                   nota_para_float(snap->estado.prova1), nota_para_float(snap->estado.prova2),
+                   nota_para_float(media_unidade(plano_aluno(snap->aluno), &snap->estado)));
+            break;
+        }
+        d = d->proximo;
+    }
+    free(snap);
+    free(acao);
+}
+
+/* Resultado de um lançamento: notas em centésimos, já com as médias
+   recalculadas pelo plano da turma. */
+typedef struct {
+    Aluno *aluno;
+    Disciplina *disciplina;
+    Nota anterior;
+    Nota atual;
+    Nota media_unidade;         // Média da unidade alterada (0 na recuperação)
+    Nota media_final_anterior;
+    Nota media_final;
+} ResultadoNota;
+
+static StatusEscola localizar_disciplina(Aluno *lista, const char *mat, const char *materia,
+                                         Aluno **a, Disciplina **d) {
+    *a = buscar_aluno(lista, (char*) mat);
+    if (!*a) return ESCOLA_NAO_ENCONTRADO;
+    for (*d = (*a)->lista_disciplinas; *d; *d = (*d)->proximo)
+        if (strcmp((*d)->nome, materia) == 0) return ESCOLA_OK;
+    return ESCOLA_DISCIPLINA_INEXISTENTE;
+}
+
+/* Grava (ou corrige) uma prova com validação completa e snapshot para o
+   Desfazer. Sem mensagens: o status diz o que aconteceu e 'res' (opcional)
+   traz as notas antes/depois. */
+StatusEscola escola_lancar_nota(Aluno *lista, Pilha *seguranca, const char *mat, const char *materia,
+                                int unidade, int prova, Nota valor, ResultadoNota *res) {
+    RASTREAR("escola_lancar_nota");
+    if (valor > NOTA_MAXIMA) return ESCOLA_NOTA_INVALIDA;
+    StatusEscola st = checar_unidade_prova(unidade, prova);
+    if (st != ESCOLA_OK) return st;
+    Aluno *a;
+    Disciplina *d;
+    if ((st = localizar_disciplina(lista, mat, materia, &a, &d)) != ESCOLA_OK) return st;
+
+    Unidade *u = &d->unidades[unidade - 1];
+    Nota anterior = (prova == 1) ? u->prova1 : u->prova2;
+    Nota media_antes = d->media_final;
+    salvar_snapshot_nota(seguranca, a, d->nome, unidade - 1);
+    gravar_nota(a, d, unidade - 1, prova, valor);
+    if (res) {
+        ResultadoNota r = {a, d, anterior, valor, (Nota) media_unidade(plano_aluno(a), u),
+                           media_antes, d->media_final};
+        *res = r;
+    }
+    return ESCOLA_OK;
+}
+
+/* Lança notas e calcula automaticamente a média da unidade, sem snapshot
+   para o Desfazer. Passa pelas mesmas validações de escola_lancar_nota:
+   nota fora de 0-10 (ou NaN), unidade fora de 1-4 e prova fora de {1, 2}
+   são ignoradas. */
+void lancar_nota(Aluno *lista, char *mat, char *materia, int unidade, int prova, float nota) {
+    if (!(nota >= 0.0f)) return; // Negativas e NaN
+    escola_lancar_nota(lista, NULL, mat, materia, unidade, prova, nota_de_float(nota), NULL);
+}
+
+// Prova de recuperação (0 = anula), sem mensagens
+StatusEscola escola_lancar_recuperacao(Aluno *lista, const char *mat, const char *materia,
+                                       Nota valor, ResultadoNota *res) {
+    RASTREAR("escola_lancar_recuperacao");
+    if (valor > NOTA_MAXIMA) return ESCOLA_NOTA_INVALIDA;
+    Aluno *a;
+    Disciplina *d;
+    StatusEscola st = localizar_disciplina(lista, mat, materia, &a, &d);
+    if (st != ESCOLA_OK) return st;
+    ResultadoNota r = {a, d, d->recuperacao, valor, 0, d->media_final, 0};
+    gravar_recuperacao(a, d, valor);
+    r.media_final = d->media_final;
+    if (res) *res = r;
+    return ESCOLA_OK;
+}
+
+// Boletim pela matrícula (ver escola_boletim)
+StatusEscola escola_boletim_matricula(Aluno *lista, const char *mat, LinhaBoletim *linhas, int cap,
+                                      ResumoBoletim *resumo) {
+    return escola_boletim(buscar_aluno(lista, (char*) mat), linhas, cap, resumo);
+}
+
+// Mensagens de erro das telas de notas (mesmo texto das validações)
+static void exibir_erro_nota(StatusEscola st, const char *mat, const char *materia, int unidade, int prova) {
+    switch (st) {
+    case ESCOLA_UNIDADE_INVALIDA:
+        printf("[ERRO] Unidade invalida: %d. Deve ser entre 1 e 4.\n", unidade); break;
+    case ESCOLA_PROVA_INVALIDA:
+        printf("[ERRO] Prova invalida: %d. Deve ser 1 ou 2.\n", prova); break;
+    case ESCOLA_NAO_ENCONTRADO:
+        printf("[ERRO] Aluno '%s' nao encontrado.\n", mat); break;
+    case ESCOLA_DISCIPLINA_INEXISTENTE:
+        printf("[ERRO] Disciplina '%s' nao encontrada.\n", materia); break;
+    default:
+        printf("[ERRO] %s.\n", escola_status_texto(st)); break;
+    }
+}
+
+/* Lanca nota com validacao completa e salva snapshot para desfazer. */
+void lancar_nota_validada(Aluno *lista, Pilha *seguranca,
+                          char *mat, char *materia,
+                          int unidade, int prova, float nota) {
+    if (!validar_nota(nota)) return;
+    ResultadoNota r;
+    StatusEscola st = escola_lancar_nota(lista, seguranca, mat, materia, unidade, prova, nota_de_float(nota), &r);
+    if (st != ESCOLA_OK) { exibir_erro_nota(st, mat, materia, unidade, prova); return; }
+    printf("[SUCESSO] Nota %.2f lancada: %s | %s | Unidade %d | Prova %d\n",
+           nota, r.aluno->nome, materia, unidade, prova);
+}
+
+/* Edita uma nota ja existente com validacao e suporte a desfazer. */
+void alterar_nota(Aluno *lista, Pilha *seguranca,
+                  char *mat, char *materia,
+                  int unidade, int prova, float nova_nota) {
+    if (!validar_nota(nova_nota)) return;
+    ResultadoNota r;
+    StatusEscola st = escola_lancar_nota(lista, seguranca, mat, materia, unidade, prova, nota_de_float(nova_nota), &r);
+    if (st != ESCOLA_OK) { exibir_erro_nota(st, mat, materia, unidade, prova); return; }
+    printf("[SUCESSO] Nota alterada: %s | %s | U%d P%d: %.2f -> %.2f | Media: %.2f\n",
+           r.aluno->nome, materia, unidade, prova, nota_para_float(r.anterior),
+           nota_para_float(r.atual), nota_para_float(r.media_unidade));
+}
+
+/* Zera uma nota especifica e recalcula a media da unidade. */
+void remover_nota(Aluno *lista, Pilha *seguranca,
+                  char *mat, char *materia, int unidade, int prova) {
+    ResultadoNota r;
+    StatusEscola st = escola_lancar_nota(lista, seguranca, mat, materia, unidade, prova, 0, &r);
+    if (st != ESCOLA_OK) { exibir_erro_nota(st, mat, materia, unidade, prova); return; }
+    printf("[SUCESSO] Nota zerada: %s | %s | Unidade %d | Prova %d\n",
+           r.aluno->nome, materia, unidade, prova);
+}
+
+/* Lanca a prova de recuperacao (0 = anula). A media anual so muda se a
+   regra da turma tiver 'recuperacao=menor'. */
+void lancar_recuperacao(Aluno *lista, char *mat, char *materia, float nota) {
+    if (!validar_nota(nota)) return;
+    ResultadoNota r;
+    StatusEscola st = escola_lancar_recuperacao(lista, mat, materia, nota_de_float(nota), &r);
+    if (st != ESCOLA_OK) { exibir_erro_nota(st, mat, materia, 1, 1); return; }
+    printf("[SUCESSO] Recuperacao %.2f lancada: %s | %s | Anual: %.2f -> %.2f\n",
+           nota, r.aluno->nome, materia, nota_para_float(r.media_final_anterior), nota_para_float(r.media_final));
+    const PlanoAvaliacao *plano = plano_aluno(r.aluno);
+    if (!plano->recuperacao)
+        printf("[INFO] A regra desta turma nao usa recuperacao (%s).\n", plano->regra);
+}
+
+/* Exibe o quadro completo de notas de um aluno (todas as disciplinas). */
+void consultar_notas_aluno(Aluno *lista, char *mat) {
+    LinhaBoletim linhas[MAX_DISCIPLINAS];
+    ResumoBoletim resumo;
+    if (escola_boletim_matricula(lista, mat, linhas, MAX_DISCIPLINAS, &resumo) == ESCOLA_NAO_ENCONTRADO) {
+        printf("[ERRO] Aluno '%s' nao encontrado.\n", mat);
+        return;
+    }
+    printf("\n======== QUADRO DE NOTAS: %s (%s) ========\n", resumo.aluno->nome, resumo.aluno->matricula);
+    for (int k = 0; k < resumo.qtd_disciplinas && k < MAX_DISCIPLINAS; k++) {
+        const LinhaBoletim *l = &linhas[k];
+        printf("%-15s | ", l->disciplina);
+        for (int i = 0; i < 4; i++) {
+            printf("U%d[P1:%.1f P2:%.1f M:%.1f] ",
+                   i+1, nota_para_float(l->provas[i][0]),
+                   nota_para_float(l->provas[i][1]),
+                   nota_para_float(l->medias[i]));
+        }
+        if (l->recuperacao) printf("Rec:%.1f ", nota_para_float(l->recuperacao));
+        printf("| Anual: %.2f\n", nota_para_float(l->media_final));
+    }
+    printf("===================================================\n");
+}
+
+/* ==========================================================================
+   FREQUÊNCIA: CHAMADA DA TURMA E ALUNOS EM RISCO (ver seção 2.7)
+   ========================================================================== */
+
+int aluno_aprovado(Aluno *a) {
+    return situacao_final(plano_aluno(a), calcular_media_aluno(a), frequencia_aluno(a));
+}
+
+static int comparar_matriculas(const void *x, const void *y) {
+    return strcmp(*(char* const*) x, *(char* const*) y);
+}
+
+/* Chamada da turma inteira numa operação: todos os alunos matriculados
+   recebem o dia em 'chamada' e, salvo os listados em 'ausentes', também em
+   'presenca'. Refazer a chamada do mesmo dia corrige as faltas. Retorna o
+   número de presentes, ou -1 se o dia ou a disciplina forem inválidos; em
+   'sem_aluno' (opcional) vem quantas matrículas ausentes (distintas) não são
+   de nenhum aluno da turma. */
+int registrar_chamada(Turma *t, const char *disciplina, int dia, char **ausentes, int qtd_ausentes,
+                      int *sem_aluno) {
+    RASTREAR("registrar_chamada");
+    if (sem_aluno) *sem_aluno = 0;
+    if (!t || dia < 1 || dia > DIAS_LETIVOS) return -1;
+    int palavra = (dia - 1) / 64;
+    uint64_t bit = 1ull << ((dia - 1) % 64);
+
+    // Ausentes ordenados e sem repetição: cada aluno é conferido por busca binária
+    qsort(ausentes, qtd_ausentes, sizeof(char*), comparar_matriculas);
+    int distintos = 0;
+    for (int i = 0; i < qtd_ausentes; i++)
+        if (distintos == 0 || strcmp(ausentes[distintos - 1], ausentes[i]) != 0)
+            ausentes[distintos++] = ausentes[i];
+    qtd_ausentes = distintos;
+    int presentes = 0, faltosos = 0, achou_disciplina = 0;
+    for (Aluno *a = t->lista_alunos; a; a = a->proximo) {
+        Disciplina *d = a->lista_disciplinas;
+        while (d && strcmp(d->nome, disciplina) != 0) d = d->proximo;
+        if (!d) continue;
+        achou_disciplina = 1;
+        char *chave = a->matricula;
+        int ausente = qtd_ausentes > 0 &&
+                      bsearch(&chave, ausentes, qtd_ausentes, sizeof(char*), comparar_matriculas) != NULL;
+        d->chamada[palavra] |= bit;
+        if (ausente) { d->presenca[palavra] &= ~bit; faltosos++; }
+        else { d->presenca[palavra] |= bit; presentes++; }
+        marcar_aluno_alterado(a);
+    }
+    if (sem_aluno) *sem_aluno = qtd_ausentes - faltosos;
+    return achou_disciplina ? presentes : -1;
+}
+
+typedef struct {
+    Aluno *aluno;
+    int geral;                  // Frequência total (milésimos)
+    int pior;                   // Pior disciplina (milésimos)
+    const char *disciplina;
+} AlunoEmRisco;
+
+static int comparar_risco(const void *x, const void *y) {
+    const AlunoEmRisco *a = (const AlunoEmRisco*) x, *b = (const AlunoEmRisco*) y;
+    if (a->geral != b->geral) return a->geral - b->geral;
+    return a->pior - b->pior;
+}
+
+/* Alunos com frequência total abaixo de FREQUENCIA_ALERTA ou alguma
+   disciplina abaixo de FREQUENCIA_MINIMA, do mais crítico ao menos. */
+void exibir_alunos_em_risco(Turma *t) {
+    RASTREAR("exibir_alunos_em_risco");
+    if (!t || t->qtd_atual == 0) {
+        printf("\nTurma sem alunos matriculados.\n");
+        return;
+    }
+    AlunoEmRisco *lista = (AlunoEmRisco*) malloc(t->qtd_atual * sizeof(AlunoEmRisco));
+    if (!lista) return;
+    int n = 0;
+    for (Aluno *a = t->lista_alunos; a && n < t->qtd_atual; a = a->proximo) {
+        int geral = frequencia_milesimos(frequencia_aluno(a));
+        if (geral < 0) continue;
+        AlunoEmRisco r = {a, geral, 1001, NULL};
+        for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo) {
+            int f = frequencia_milesimos(frequencia_disciplina(d));
+            if (f >= 0 && f < r.pior) { r.pior = f; r.disciplina = d->nome; }
+        }
+        if (geral < FREQUENCIA_ALERTA || r.pior < FREQUENCIA_MINIMA) lista[n++] = r;
+    }
+    qsort(lista, n, sizeof(AlunoEmRisco), comparar_risco);
+
+    printf("\n--- ALUNOS EM RISCO POR FALTAS | TURMA %s ---\n", t->codigo);
+    if (n == 0) printf("Nenhum aluno abaixo de %.0f%% de frequencia.\n", FREQUENCIA_ALERTA / 10.0);
+    for (int i = 0; i < n; i++)
+        printf("%-20s | Mat: %-12s | Freq: %5.1f%% | Pior: %s (%.1f%%)%s\n",
+               lista[i].aluno->nome, lista[i].aluno->matricula, lista[i].geral / 10.0,
+               lista[i].disciplina ? lista[i].disciplina : "-", lista[i].pior / 10.0,
+               lista[i].geral < FREQUENCIA_MINIMA ? " [REPROVADO POR FALTA]" : "");
+    free(lista);
+}
+
+/* Formata uma linha do iterador de fechamento e guarda no cache do proprio
+   aluno, junto com a media e a situacao (media + frequencia). */
+static void renderizar_bloco_relatorio(const LinhaRelatorio *l) {
+    Aluno *atual = (Aluno*) l->resumo.aluno;
+    Texto *tx = &atual->cache_relatorio.texto;
+    texto_limpar(tx);
+    const char *status = l->resumo.aprovado ? "APROVADO " : "REPROVADO";
+    texto_printf(tx, "\n>> %-20s | Mat: %-12s | Media: %5.2f | [%s]",
+                 atual->nome, atual->matricula, nota_para_float(l->resumo.media_geral), status);
+    if (l->resumo.frequencia >= 0)
+        texto_printf(tx, " Freq: %.1f%%%s", l->resumo.frequencia / 10.0,
+                     l->resumo.frequencia < FREQUENCIA_MINIMA ? " (< 75%)" : "");
+    texto_printf(tx, "\n");
+    for (int k = 0; k < l->resumo.qtd_disciplinas && k < MAX_DISCIPLINAS; k++) {
+        const LinhaBoletim *d = &l->disciplinas[k];
+        texto_printf(tx, "   %-15s | ", d->disciplina);
+        for (int i = 0; i < 4; i++)
+            texto_printf(tx, "U%d:%.1f ", i+1, nota_para_float(d->medias[i]));
+        if (d->recuperacao) texto_printf(tx, "Rec:%.1f ", nota_para_float(d->recuperacao));
+        texto_printf(tx, "| Anual: %.2f", nota_para_float(d->media_final));
+        if (d->abaixo_aprovacao) texto_printf(tx, " [!]");
+        if (d->frequencia.aulas)
+            texto_printf(tx, " | Faltas: %d/%d", d->frequencia.aulas - d->frequencia.presencas, d->frequencia.aulas);
+        texto_printf(tx, "\n");
+    }
+    texto_printf(tx, "   ----------------------------------------------------------\n");
+    atual->media_geral = l->resumo.media_geral;
+    atual->aprovado = l->resumo.aprovado;
+    atual->cache_relatorio.versao = atual->versao;
+}
+
+/* Remonta o relatorio da turma sobre escola_relatorio_*: os totais vem do
+   iterador e so os alunos cuja versao mudou desde a ultima renderizacao
+   sao reformatados. */
+static void renderizar_relatorio_turma(Turma *t) {
+    RASTREAR("renderizar_relatorio_turma");
+    Texto *tx = &t->cache_relatorio.texto;
+    texto_limpar(tx);
+    IteradorRelatorio it;
+    LinhaRelatorio l;
+    escola_relatorio_iniciar(t, &it);
+    texto_printf(tx, "\n##############################################################\n");
+    texto_printf(tx, "##    FECHAMENTO DE NOTAS — TURMA %-10s             ##\n", t->codigo);
+    texto_printf(tx, "##    Serie: %d | Alunos: %d / %d vagas                  ##\n",
+                 t->serie, t->qtd_atual, t->limite_vagas);
+    texto_printf(tx, "##############################################################\n");
+    while (escola_relatorio_proximo(&it, &l)) {
+        Aluno *atual = (Aluno*) l.resumo.aluno;
+        if (!cache_valido(&atual->cache_relatorio, atual->versao))
+            renderizar_bloco_relatorio(&l);
+        texto_anexar(tx, &atual->cache_relatorio.texto);
+    }
+    int aprovados = it.aprovados, reprovados = it.reprovados;
+    texto_printf(tx, "\n##############################################################\n");
+    texto_printf(tx, "##  Aprovados: %d | Reprovados: %d | Total: %d             ##\n",
+                 aprovados, reprovados, aprovados + reprovados);
+    if (aprovados + reprovados > 0)
+        texto_printf(tx, "##  Taxa de aprovacao: %.1f%%                              ##\n",
+                     100.0f * aprovados / (aprovados + reprovados));
+    texto_printf(tx, "##############################################################\n\n");
+    t->cache_relatorio.versao = t->versao;
+}
+
+/* Fechamento da turma: percorre a lista, calcula medias e exibe
+   relatorio com Aprovados (media >= 5.0) e Reprovados.
+   Se nenhuma nota/matricula mudou desde a ultima chamada, o texto ja
+   renderizado e servido direto do cache da turma. */
+void gerar_relatorio_final(Turma *t) {
+    RASTREAR("gerar_relatorio_final");
+    if (!t) { printf("[ERRO] Nenhuma turma disponivel.\n"); return; }
+    if (!t->lista_alunos) {
+        printf("[AVISO] Turma %s sem alunos matriculados.\n", t->codigo);
+        return;
+    }
+    if (!cache_valido(&t->cache_relatorio, t->versao)) renderizar_relatorio_turma(t);
+    fputs(texto_conteudo(&t->cache_relatorio.texto), stdout);
+}
+
+/* ==========================================================================
+   FECHAMENTO DO ANO LETIVO (PROMOÇÃO EM LOTE)
+   ========================================================================== */
+
+typedef struct {
+    int aprovados;       // Avançaram uma série
+    int retidos;         // Permanecem na série
+    int formandos;       // Aprovados na 12ª série (deixam a escola)
+    int em_fila;         // Sem vaga na turma de destino: foram para a fila
+    int turmas_criadas;
+    int serie_invalida;  // Série fora de 1-12: ficaram na turma, sem promoção
+    int acima_limite;    // Sem vaga e sem como entrar na fila: excedem o limite da turma
+} ResumoPromocao;
+
+/* Prepara a grade do aluno para o novo ano reaproveitando os nós de
+   Disciplina: zera notas e vínculos e, na passagem 9 -> 10, renomeia os 8
+   nós do Fundamental para o Médio e aloca só os 2 que faltam. A ordem final
+   é a mesma produzida por matricular_aluno. */
+static int reconfigurar_grade(Aluno *a, int nova_serie) {
+    int qtd = (nova_serie >= 10) ? 10 : 8;
+    const char **nomes = (nova_serie >= 10) ? DISCIPLINAS_MEDIO : DISCIPLINAS_FUNDAMENTAL;
+
+    int existentes = 0;
+    for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo) existentes++;
+    // Os nós que faltam são alocados à parte: sem memória, a grade fica intacta
+    Disciplina *novos = NULL, *ultimo = NULL;
+    for (; existentes < qtd; existentes++) {
+        Disciplina *d = (Disciplina*) malloc(sizeof(Disciplina));
+        if (!d) {
+            while (novos) { Disciplina *prox = novos->proximo; free(novos); novos = prox; }
+            return 0;
+        }
+        d->proximo = novos;
+        novos = d;
+        if (!ultimo) ultimo = d;
+    }
+    desvincular_docentes_aluno(a); // Enquanto a->turma ainda é a turma dos vínculos
+    if (novos) {
+        ultimo->proximo = a->lista_disciplinas;
+        a->lista_disciplinas = novos;
+    }
+
+    int i = qtd - 1;
+    for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo, i--) {
+        strcpy(d->nome, nomes[i]);
+        d->docente = NULL; // Nós novos: os antigos já foram desvinculados
+        memset(d->unidades, 0, sizeof(d->unidades));
+        d->media_final = 0;
+        d->recuperacao = 0;
+        memset(d->chamada, 0, sizeof(d->chamada));
+        memset(d->presenca, 0, sizeof(d->presenca));
+    }
+    a->serie = nova_serie;
+    marcar_aluno_alterado(a);
+    return 1;
+}
+
+/* Zera o quadro do aluno no histórico da turma de destino (se ele já tinha
+   registros lá): as consultas por data a partir de agora partem de zero. */
+static void historico_reiniciar_aluno(Turma *t, Aluno *a) {
+    HistoricoTurma *h = t->historico;
+    if (!h) return;
+    for (int i = 0; i < h->qtd_alunos; i++) {
+        AlunoHistorico *ah = &h->alunos[i];
+        if (strcmp(ah->matricula, a->matricula) != 0) continue;
+        time_t agora = time(NULL);
+        if (agora < h->ultimo_instante) agora = h->ultimo_instante;
+        h->ultimo_instante = agora;
+        memset(ah->quadro, 0, sizeof(ah->quadro));
+        for (int s = 0; s < MAX_DISCIPLINAS * 8; s++) ah->origem[s] = HIST_SEM_REGISTRO;
+        ah->serie = a->serie;
+        // Sem memoria, a lacuna fica marcada e o proximo registro tenta de novo
+        if (!historico_checkpoint(ah, ah->ultimo, agora)) ah->desde_checkpoint = HIST_CHECKPOINT;
+        return;
+    }
+}
+
+/* Esvazia a pilha de desfazer: snapshots do ano anterior apontam para
+   notas que já não existem (e para formandos já liberados). */
+void limpar_pilha(Pilha *p) {
+    if (!p) return;
+    while (p->topo) {
+        Acao *a = p->topo;
+        p->topo = a->proximo;
+        if (strcmp(a->tipo, "nota") == 0) free(a->dado);
+        free(a);
+    }
+}
+
+/* Promoção de fim de ano em uma única passada:
+   1) decide Aprovado/Reprovado pela mesma regra do relatório de fechamento
+      (média e frequência)
+      e distribui os alunos em baldes pela série de destino (12ª aprovada
+      = formando, liberado da memória);
+   2) reaproveita o nó de cada aluno e sua lista de disciplinas;
+   3) reconstrói as turmas a partir dos baldes, respeitando limite_vagas:
+      retidos voltam para a própria sala enquanto houver vaga e os demais
+      vão para a turma da série com mais vagas livres. Só quando todas as
+      turmas da série lotam é que o excedente vai para a fila de espera
+      (a turma "A" só é criada se a série não tiver nenhuma). */
+void promover_ano_letivo(Turma **lista_turmas, FilaEspera *f, Pilha *seguranca, ResumoPromocao *res) {
+    RASTREAR("promover_ano_letivo");
+    Aluno *baldes[13] = {NULL};
+    Aluno *invalidos = NULL;
+    memset(res, 0, sizeof(ResumoPromocao));
+
+    // Passo 1: classificação e esvaziamento das turmas
+    for (Turma *t = *lista_turmas; t; t = t->proximo_turma) {
+        Aluno *a = t->lista_alunos;
+        roster_esvaziar(t); // Os nós seguem encadeados por 'proximo' até irem aos baldes
+        while (a) {
+            Aluno *prox = a->proximo;
+            if (a->serie < 1 || a->serie > 12) {
+                // Dado corrompido: não há série de destino; volta para a mesma turma
+                a->proximo = invalidos;
+                invalidos = a;
+                res->serie_invalida++;
+                a = prox;
+                continue;
+            }
+            int aprovado = aluno_aprovado(a);
+            int destino = aprovado ? a->serie + 1 : a->serie;
+
+            if (destino > 12) {
+                emitir_evento(EVENTO_REMOCAO, t, a, NULL, 0, 0, 0);
+                desvincular_docentes_aluno(a);
+                a->turma = NULL;
+                deletar_aluno(a);
+                res->formandos++;
+            } else {
+                if (!reconfigurar_grade(a, destino)) {
+                    // Sem memória para a nova grade: mantém na série atual
+                    destino = a->serie;
+                    aprovado = 0;
+                }
+                if (aprovado) res->aprovados++; else res->retidos++;
+                a->proximo = baldes[destino];
+                baldes[destino] = a;
+            }
+            a = prox;
+        }
+        t->qtd_atual = 0;
+        marcar_turma_alterada(t);
+    }
+    while (invalidos) {
+        Aluno *prox = invalidos->proximo;
+        invalidos->proximo = NULL;
+        roster_inserir(invalidos->turma, invalidos);
+        invalidos->turma->qtd_atual++;
+        invalidos = prox;
+    }
+
+    // Passo 2: reconstrução das turmas por série
+    for (int serie = 1; serie <= 12; serie++) {
+        if (!baldes[serie]) continue;
+        if (!buscar_turma_serie(*lista_turmas, serie) && criar_turma_serie(lista_turmas, serie))
+            res->turmas_criadas++;
+
+        // 2a) Retidos voltam para a própria sala: só relinka, sem novo evento de matrícula
+        Aluno *pendentes = NULL;
+        Aluno *a = baldes[serie];
+        while (a) {
+            Aluno *prox = a->proximo;
+            Turma *origem = a->turma;
+            a->proximo = NULL;
+            if (origem && origem->serie == serie && origem->qtd_atual < origem->limite_vagas) {
+                historico_reiniciar_aluno(origem, a);
+                roster_inserir(origem, a);
+                origem->qtd_atual++;
+            } else {
+                a->proximo = pendentes;
+                pendentes = a;
+            }
+            a = prox;
+        }
+
+        // 2b) Demais: turma da série com mais vagas; sem vaga em nenhuma, fila de espera
+        a = pendentes;
+        while (a) {
+            Aluno *prox = a->proximo;
+            Turma *origem = a->turma;
+            Turma *t = turma_serie_com_vaga(*lista_turmas, serie);
+            a->proximo = NULL;
+            if (origem != t) emitir_evento(EVENTO_REMOCAO, origem, a, NULL, 0, 0, 0);
+            a->turma = NULL;
+            if (t) {
+                historico_reiniciar_aluno(t, a);
+                if (origem == t) {
+                    roster_inserir(t, a);
+                    t->qtd_atual++;
+                    a->turma = t;
+                } else {
+                    vincular_aluno_turma(t, a);
+                }
+            } else if (escola_enfileirar(f, a, NULL) == ESCOLA_OK) { // O resumo informa o total
+                res->em_fila++;
+            } else {
+                // Fila indisponível (sem memória): o aluno não pode sumir da escola
+                Turma *destino = buscar_turma_serie(*lista_turmas, serie);
+                if (!destino) destino = origem;
+                historico_reiniciar_aluno(destino, a);
+                anexar_aluno_turma(destino, a);
+                indice_inserir(ENTRADA_ALUNO, a, a->nome);
+                res->acima_limite++;
+            }
+            a = prox;
+        }
+    }
+
+    limpar_pilha(seguranca);
+}
+
+/* ==========================================================================
+   ALOCAÇÃO AUTOMÁTICA DE DOCENTES (GULOSO + BUSCA LOCAL)
+   ========================================================================== */
+
+/* Cada par (turma, disciplina) de uma turma com alunos e um encargo. O
+   professor esta habilitado se alguma area do seu 'departamento' (separadas
+   por ',' ou '/') for o departamento da disciplina (DEPARTAMENTO_DISCIPLINA)
+   ou a propria disciplina, e recebe no maximo carga_maxima encargos.
+   1. Guloso, mais restrito primeiro: a cada passo atende a disciplina com
+      menor folga (capacidade livre dos habilitados / encargos pendentes) e
+      da o encargo ao habilitado de menor custo marginal, preferindo, no
+      empate, quem ja esta vinculado a ele.
+   2. Busca local: um encargo sem professor tenta liberar um habilitado
+      lotado, movendo um encargo dele para outro professor com folga; depois,
+      passadas de equilibrio movem encargos enquanto isso reduzir
+      soma(carga^2 / carga_maxima), minima quando a carga e proporcional a
+      capacidade de cada um.
+   Nada e gravado nos alunos ate aplicar_alocacao. */
+
+#define ALOC_PASSADAS  16   // Limite de passadas de equilibrio
+
+typedef struct {
+    Turma *turma;
+    int disciplina;         // Indice na grade da serie
+    int tipo;               // Indice em DEPARTAMENTO_DISCIPLINA (-1 = fora da tabela)
+    int professor;          // Indice em Alocacao.professores (-1 = sem professor)
+    int atual;              // Professor hoje vinculado em todos os alunos (-1 = nenhum/misto)
+} EncargoAlocacao;
+
+typedef struct {
+    Professor **professores;
+    uint32_t *areas;        // Bit i: habilitado para o tipo i
+    int *carga;
+    int qtd_professores;
+    EncargoAlocacao *encargos;
+    int qtd_encargos;
+    int *habilitados;       // Professores habilitados, agrupados por tipo
+    int inicio_tipo[QTD_DISCIPLINAS_DEPTO + 1];
+    int sem_professor;
+    int mantidos;           // Encargos que continuam com o professor atual
+    int movimentos;         // Trocas feitas pela busca local
+} Alocacao;
+
+static int tipo_disciplina_alocacao(const char *nome) {
+    for (int i = 0; i < QTD_DISCIPLINAS_DEPTO; i++)
+        if (strcmp(DEPARTAMENTO_DISCIPLINA[i].disciplina, nome) == 0) return i;
+    return -1;
+}
+
+/* Tipos de encargo que o professor pode assumir (bit i = tipo i). */
+static uint32_t areas_professor(const Professor *p) {
+    char copia[50], chave[50], ref[50];
+    uint32_t mascara = 0;
+    snprintf(copia, sizeof(copia), "%s", p->departamento);
+    for (char *area = copia, *prox; area; area = prox) {
+        prox = strpbrk(area, ",/");
+        if (prox) *prox++ = '\0';
+        while (*area == ' ') area++;
+        normalizar_nome(chave, sizeof(chave), area);
+        size_t n = strlen(chave);
+        while (n > 0 && chave[n - 1] == ' ') chave[--n] = '\0';
+        if (n == 0) continue;
+        for (int i = 0; i < QTD_DISCIPLINAS_DEPTO; i++) {
+            normalizar_nome(ref, sizeof(ref), DEPARTAMENTO_DISCIPLINA[i].departamento);
+            int igual = strcmp(ref, chave) == 0;
+            normalizar_nome(ref, sizeof(ref), DEPARTAMENTO_DISCIPLINA[i].disciplina);
+            if (igual || strcmp(ref, chave) == 0) mascara |= 1u << i;
+        }
+    }
+    return mascara;
+}
+
+static int aloc_tem_folga(const Alocacao *a, int i) {
+    return a->carga[i] < a->professores[i]->carga_maxima;
+}
+
+/* Custo marginal de mais um encargo para i, (2c+1)/cap, comparado em inteiros. */
+static int aloc_mais_barato(const Alocacao *a, int i, int j) {
+    long ci = 2L * a->carga[i] + 1, cj = 2L * a->carga[j] + 1;
+    return ci * a->professores[j]->carga_maxima < cj * a->professores[i]->carga_maxima;
+}
+
+/* Habilitado com folga e menor custo marginal (exceto 'excluir'); -1 se nenhum. */
+static int aloc_escolher(const Alocacao *a, const EncargoAlocacao *e, int excluir) {
+    if (e->tipo < 0) return -1;
+    int melhor = -1;
+    for (int k = a->inicio_tipo[e->tipo]; k < a->inicio_tipo[e->tipo + 1]; k++) {
+        int i = a->habilitados[k];
+        if (i == excluir || !aloc_tem_folga(a, i)) continue;
+        if (melhor < 0 || aloc_mais_barato(a, i, melhor) ||
+            (i == e->atual && !aloc_mais_barato(a, melhor, i))) melhor = i;
+    }
+    return melhor;
+}
+
+static void aloc_atribuir(Alocacao *a, EncargoAlocacao *e, int prof) {
+    if (e->professor >= 0) a->carga[e->professor]--;
+    e->professor = prof;
+    if (prof >= 0) a->carga[prof]++;
+}
+
+/* Cadeia de uma troca: algum habilitado lotado cede um encargo a outro
+   professor com folga e assume 'e'. */
+static int aloc_reparar(Alocacao *a, EncargoAlocacao *e) {
+    if (e->tipo < 0) return 0;
+    for (int j = 0; j < a->qtd_encargos; j++) {
+        EncargoAlocacao *outro = &a->encargos[j];
+        int p = outro->professor;
+        if (p < 0 || !(a->areas[p] & (1u << e->tipo))) continue;
+        int q = aloc_escolher(a, outro, p);
+        if (q < 0) continue;
+        aloc_atribuir(a, outro, q);
+        aloc_atribuir(a, e, p);
+        a->movimentos++;
+        return 1;
+    }
+    return 0;
+}
+
+void liberar_alocacao(Alocacao *a) {
+    free(a->professores);
+    free(a->areas);
+    free(a->carga);
+    free(a->encargos);
+    free(a->habilitados);
+    memset(a, 0, sizeof(Alocacao));
+}
+
+/* Monta a alocacao de todas as turmas com alunos. Retorna 0 sem memoria. */
+int calcular_alocacao(Professor *lista_professores, Turma *lista_turmas, Alocacao *a) {
+    RASTREAR("calcular_alocacao");
+    memset(a, 0, sizeof(Alocacao));
+    for (Professor *p = lista_professores; p; p = p->proximo) a->qtd_professores++;
+    for (Turma *t = lista_turmas; t; t = t->proximo_turma)
+        if (t->lista_alunos) a->qtd_encargos += (t->serie >= 10) ? 10 : 8;
+
+    a->professores = (Professor**) malloc(sizeof(Professor*) * (a->qtd_professores + 1));
+    a->areas = (uint32_t*) malloc(sizeof(uint32_t) * (a->qtd_professores + 1));
+    a->carga = (int*) calloc(a->qtd_professores + 1, sizeof(int));
+    a->habilitados = (int*) malloc(sizeof(int) * (a->qtd_professores * QTD_DISCIPLINAS_DEPTO + 1));
+    a->encargos = (EncargoAlocacao*) malloc(sizeof(EncargoAlocacao) * (a->qtd_encargos + 1));
+    int *fila = (int*) malloc(sizeof(int) * (a->qtd_encargos + 1));
+    if (!a->professores || !a->areas || !a->carga || !a->habilitados || !a->encargos || !fila) {
+        free(fila);
+        liberar_alocacao(a);
+        return 0;
+    }
+
+    int i = 0;
+    for (Professor *p = lista_professores; p; p = p->proximo, i++) {
+        a->professores[i] = p;
+        a->areas[i] = (p->carga_maxima > 0) ? areas_professor(p) : 0;
+    }
+    int n = 0;
+    for (int tipo = 0; tipo < QTD_DISCIPLINAS_DEPTO; tipo++) {
+        a->inicio_tipo[tipo] = n;
+        for (i = 0; i < a->qtd_professores; i++)
+            if (a->areas[i] & (1u << tipo)) a->habilitados[n++] = i;
+    }
+    a->inicio_tipo[QTD_DISCIPLINAS_DEPTO] = n;
+
+    // Encargos, com o vinculo atual quando todos os alunos da turma concordam
+    int e = 0;
+    for (Turma *t = lista_turmas; t; t = t->proximo_turma) {
+        if (!t->lista_alunos) continue;
+        int qtd = (t->serie >= 10) ? 10 : 8;
+        Professor *vinculo[MAX_DISCIPLINAS] = {0};
+        int misto[MAX_DISCIPLINAS] = {0};
+        for (Aluno *al = t->lista_alunos; al; al = al->proximo)
+            for (Disciplina *d = al->lista_disciplinas; d; d = d->proximo) {
+                int k = indice_disciplina(t->serie, d->nome);
+                if (k < 0) continue;
+                if (al == t->lista_alunos) vinculo[k] = d->docente;
+                else if (vinculo[k] != d->docente) misto[k] = 1;
+            }
+        for (int k = 0; k < qtd; k++) {
+            EncargoAlocacao *enc = &a->encargos[e++];
+            enc->turma = t;
+            enc->disciplina = k;
+            enc->tipo = tipo_disciplina_alocacao(nome_disciplina(t->serie, k));
+            enc->professor = -1;
+            enc->atual = -1;
+            if (vinculo[k] && !misto[k])
+                for (i = 0; i < a->qtd_professores; i++)
+                    if (a->professores[i] == vinculo[k]) { enc->atual = i; break; }
+        }
+    }
+
+    // 1. Guloso: encargos agrupados por tipo; a cada passo, o tipo mais restrito
+    int inicio[QTD_DISCIPLINAS_DEPTO + 1] = {0}, proximo[QTD_DISCIPLINAS_DEPTO];
+    for (e = 0; e < a->qtd_encargos; e++)
+        if (a->encargos[e].tipo >= 0) inicio[a->encargos[e].tipo + 1]++;
+    for (int tipo = 0; tipo < QTD_DISCIPLINAS_DEPTO; tipo++) {
+        inicio[tipo + 1] += inicio[tipo];
+        proximo[tipo] = inicio[tipo];
+    }
+    for (e = 0; e < a->qtd_encargos; e++)
+        if (a->encargos[e].tipo >= 0) fila[proximo[a->encargos[e].tipo]++] = e;
+    for (int tipo = 0; tipo < QTD_DISCIPLINAS_DEPTO; tipo++) proximo[tipo] = inicio[tipo];
+
+    for (;;) {
+        int escolhido = -1;
+        long folga_escolhido = 0, pendentes_escolhido = 1;
+        for (int tipo = 0; tipo < QTD_DISCIPLINAS_DEPTO; tipo++) {
+            long pendentes = inicio[tipo + 1] - proximo[tipo];
+            if (pendentes == 0) continue;
+            long folga = 0;
+            for (int k = a->inicio_tipo[tipo]; k < a->inicio_tipo[tipo + 1]; k++) {
+                int h = a->habilitados[k];
+                if (aloc_tem_folga(a, h)) folga += a->professores[h]->carga_maxima - a->carga[h];
+            }
+            if (escolhido < 0 || folga * pendentes_escolhido < folga_escolhido * pendentes) {
+                escolhido = tipo;
+                folga_escolhido = folga;
+                pendentes_escolhido = pendentes;
+            }
+        }
+        if (escolhido < 0) break;
+        EncargoAlocacao *enc = &a->encargos[fila[proximo[escolhido]++]];
+        int prof = aloc_escolher(a, enc, -1);
+        if (prof >= 0) aloc_atribuir(a, enc, prof);
+    }
+    free(fila);
+
+    // 2a. Reparo: um tipo que falhou so e tentado de novo depois de alguma troca
+    int falhou[QTD_DISCIPLINAS_DEPTO] = {0};
+    for (e = 0; e < a->qtd_encargos; e++) {
+        EncargoAlocacao *enc = &a->encargos[e];
+        if (enc->professor >= 0 || enc->tipo < 0 || falhou[enc->tipo]) continue;
+        if (aloc_reparar(a, enc)) memset(falhou, 0, sizeof(falhou));
+        else falhou[enc->tipo] = 1;
+    }
+
+    // 2b. Equilibrio: move se (2c_q+1)/cap_q < (2c_p-1)/cap_p
+    for (int passada = 0; passada < ALOC_PASSADAS; passada++) {
+        int mudou = 0;
+        for (e = 0; e < a->qtd_encargos; e++) {
+            EncargoAlocacao *enc = &a->encargos[e];
+            int p = enc->professor;
+            if (p < 0) continue;
+            int q = aloc_escolher(a, enc, p);
+            if (q < 0) continue;
+            long custo_q = 2L * a->carga[q] + 1, ganho_p = 2L * a->carga[p] - 1;
+            if (custo_q * a->professores[p]->carga_maxima < ganho_p * a->professores[q]->carga_maxima) {
+                aloc_atribuir(a, enc, q);
+                a->movimentos++;
+                mudou = 1;
+            }
+        }
+        if (!mudou) break;
+    }
+
+    for (e = 0; e < a->qtd_encargos; e++) {
+        if (a->encargos[e].professor < 0) a->sem_professor++;
+        else if (a->encargos[e].professor == a->encargos[e].atual) a->mantidos++;
+    }
+    return 1;
+}
+
+/* Grava a alocacao nos alunos: cada encargo vincula (ou, sem professor,
+   desvincula) a disciplina em todos os alunos da turma. Retorna quantos
+   encargos mudaram de professor. */
+int aplicar_alocacao(const Alocacao *a) {
+    RASTREAR("aplicar_alocacao");
+    int alterados = 0;
+    for (int e = 0; e < a->qtd_encargos; e++) {
+        const EncargoAlocacao *enc = &a->encargos[e];
+        Professor *p = (enc->professor >= 0) ? a->professores[enc->professor] : NULL;
+        const char *materia = nome_disciplina(enc->turma->serie, enc->disciplina);
+        int mudou = 0;
+        for (Aluno *al = enc->turma->lista_alunos; al; al = al->proximo)
+            for (Disciplina *d = al->lista_disciplinas; d; d = d->proximo) {
+                if (strcmp(d->nome, materia) != 0) continue;
+                if (d->docente != p && vincular_docente(al, d, p)) mudou = 1;
+                break;
+            }
+        alterados += mudou;
+    }
+    return alterados;
+}
+
+void exibir_alocacao(const Alocacao *a) {
+    printf("\n--- ALOCACAO DE DOCENTES ---\n");
+    printf("Encargos (turma x disciplina): %d | Professores: %d\n", a->qtd_encargos, a->qtd_professores);
+    printf("Atribuidos: %d | Mantidos do vinculo atual: %d | Sem professor: %d | Trocas na busca local: %d\n",
+           a->qtd_encargos - a->sem_professor, a->mantidos, a->sem_professor, a->movimentos);
+    int ocupacao_min = -1, ocupacao_max = -1, ocupados = 0;
+    for (int i = 0; i < a->qtd_professores; i++) {
+        if (!a->areas[i]) continue;
+        int ocupacao = a->carga[i] * 100 / a->professores[i]->carga_maxima;
+        if (ocupacao_min < 0 || ocupacao < ocupacao_min) ocupacao_min = ocupacao;
+        if (ocupacao > ocupacao_max) ocupacao_max = ocupacao;
+        if (a->carga[i] > 0) ocupados++;
+    }
+    if (ocupacao_max >= 0)
+        printf("Professores com encargos: %d | Ocupacao da carga maxima: %d%% a %d%%\n",
+               ocupados, ocupacao_min, ocupacao_max);
+    if (a->sem_professor == 0) return;
+    printf("--- Encargos sem professor ---\n");
+    for (int e = 0; e < a->qtd_encargos; e++) {
+        const EncargoAlocacao *enc = &a->encargos[e];
+        if (enc->professor >= 0) continue;
+        int habilitados = (enc->tipo >= 0) ? a->inicio_tipo[enc->tipo + 1] - a->inicio_tipo[enc->tipo] : 0;
+        printf("Turma %-6s | %-15s | Depto: %-10s | %s\n",
+               enc->turma->codigo, nome_disciplina(enc->turma->serie, enc->disciplina),
+               (enc->tipo >= 0) ? DEPARTAMENTO_DISCIPLINA[enc->tipo].departamento : "-",
+               habilitados ? "carga maxima dos habilitados esgotada" : "nenhum professor habilitado");
+    }
+}
+
+/* ==========================================================================
+   ESTATÍSTICAS DE DESEMPENHO (PASSADA ÚNICA, ACUMULADORES COMBINÁVEIS)
+   ========================================================================== */
+
+/* Cada acumulador mantém contagem, média e soma dos quadrados dos desvios
+   pelo método de Welford (estável numericamente), mínimo/máximo e um
+   histograma de faixas de 0.1 ponto. Dois acumuladores se combinam sem
+   revisitar as notas (fórmula de Chan), então turma -> série -> escola é
+   só uma soma de acumuladores. Percentis são aproximados pelo histograma,
+   sem ordenar nada. */
+
+#define EST_FAIXAS         100   // Faixas de 0.1 ponto entre 0.0 e 10.0
+#define EST_DISCIPLINAS    13    // União das grades Fundamental + Médio
+#define EST_ANUAL          4     // Índice da média anual (0-3 são as unidades)
+
+static const char *DISCIPLINAS_ESTATISTICA[EST_DISCIPLINAS] = {
+    "Portugues", "Matematica", "Historia", "Geografia", "Ciencias", "Ingles", "Artes",
+    "Educacao Fisica", "Fisica", "Quimica", "Biologia", "Filosofia", "Sociologia"
+};
+
+typedef struct {
+    long     n;
+    double   media;
+    double   m2;                 // Soma dos quadrados dos desvios (Welford)
+    int      minimo, maximo;     // Centésimos
+    uint32_t faixas[EST_FAIXAS];
+} Acumulador;
+
+typedef struct {
+    char rotulo[32];
+    int  alunos;
+    Acumulador disc[EST_DISCIPLINAS][EST_ANUAL + 1];
+} EstatisticasGrupo;
+
+static void acumulador_adicionar(Acumulador *acc, int centesimos) {
+    acc->n++;
+    double x = centesimos;
+    double delta = x - acc->media;
+    acc->media += delta / acc->n;
+    acc->m2 += delta * (x - acc->media);
+    if (acc->n == 1 || centesimos < acc->minimo) acc->minimo = centesimos;
+    if (acc->n == 1 || centesimos > acc->maximo) acc->maximo = centesimos;
+    int faixa = centesimos / (NOTA_MAXIMA / EST_FAIXAS);
+    if (faixa >= EST_FAIXAS) faixa = EST_FAIXAS - 1; // 10.0 entra na última faixa
+    acc->faixas[faixa]++;
+}
+
+/* Combina 'src' em 'dst' como se as notas tivessem sido vistas juntas. */
+static void acumulador_combinar(Acumulador *dst, const Acumulador *src) {
+    if (src->n == 0) return;
+    if (dst->n == 0) { *dst = *src; return; }
+    long n = dst->n + src->n;
+    double delta = src->media - dst->media;
+    dst->m2 += src->m2 + delta * delta * ((double) dst->n * src->n / n);
+    dst->media += delta * src->n / n;
+    dst->n = n;
+    if (src->minimo < dst->minimo) dst->minimo = src->minimo;
+    if (src->maximo > dst->maximo) dst->maximo = src->maximo;
+    for (int i = 0; i < EST_FAIXAS; i++) dst->faixas[i] += src->faixas[i];
+}
+
+static double acumulador_desvio(const Acumulador *acc) {
+    return (acc->n > 1) ? sqrt(acc->m2 / (acc->n - 1)) : 0.0;
+}
+
+/* Percentil aproximado (em centésimos): localiza a faixa que contém a
+   posição pedida e interpola linearmente dentro dela. */
+static double acumulador_percentil(const Acumulador *acc, double p) {
+    if (acc->n == 0) return 0.0;
+    double alvo = p * acc->n;
+    double largura = (double) NOTA_MAXIMA / EST_FAIXAS;
+    long acumulado = 0;
+    for (int i = 0; i < EST_FAIXAS; i++) {
+        if (acc->faixas[i] == 0) continue;
+        if (acumulado + acc->faixas[i] >= alvo) {
+            double v = i * largura + (alvo - acumulado) / acc->faixas[i] * largura;
+            if (v < acc->minimo) v = acc->minimo;
+            if (v > acc->maximo) v = acc->maximo;
+            return v;
+        }
+        acumulado += acc->faixas[i];
+    }
+    return acc->maximo;
+}
+
+static int indice_estatistica(const char *nome) {
+    for (int i = 0; i < EST_DISCIPLINAS; i++)
+        if (strcmp(DISCIPLINAS_ESTATISTICA[i], nome) == 0) return i;
+    return -1;
+}
+
+/* Passada única sobre as notas da turma: cada média de unidade e cada
+   média anual alimenta o acumulador da disciplina correspondente. */
+void coletar_estatisticas_turma(Turma *t, EstatisticasGrupo *est) {
+    RASTREAR("coletar_estatisticas_turma");
+    memset(est, 0, sizeof(EstatisticasGrupo));
+    snprintf(est->rotulo, sizeof(est->rotulo), "Turma %s", t->codigo);
+    const PlanoAvaliacao *plano = plano_turma(t);
+    for (Aluno *a = t->lista_alunos; a; a = a->proximo) {
+        est->alunos++;
+        for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo) {
+            int k = indice_estatistica(d->nome);
+            if (k < 0) continue;
+            for (int u = 0; u < 4; u++)
+                acumulador_adicionar(&est->disc[k][u], media_unidade(plano, &d->unidades[u]));
+            acumulador_adicionar(&est->disc[k][EST_ANUAL], d->media_final);
+        }
+    }
+}
+
+void combinar_estatisticas(EstatisticasGrupo *dst, const EstatisticasGrupo *src) {
+    dst->alunos += src->alunos;
+    for (int k = 0; k < EST_DISCIPLINAS; k++)
+        for (int u = 0; u <= EST_ANUAL; u++)
+            acumulador_combinar(&dst->disc[k][u], &src->disc[k][u]);
+}
+
+static void exibir_linha_acumulador(const char *rotulo, const Acumulador *acc) {
+    printf("   %-5s | n=%-4ld | Media %5.2f | DP %4.2f | Min %5.2f | Max %5.2f | P25 %5.2f P50 %5.2f P75 %5.2f P90 %5.2f\n",
+           rotulo, acc->n, acc->media / NOTA_ESCALA, acumulador_desvio(acc) / NOTA_ESCALA,
+           nota_para_float(acc->minimo), nota_para_float(acc->maximo),
+           acumulador_percentil(acc, 0.25) / NOTA_ESCALA, acumulador_percentil(acc, 0.50) / NOTA_ESCALA,
+           acumulador_percentil(acc, 0.75) / NOTA_ESCALA, acumulador_percentil(acc, 0.90) / NOTA_ESCALA);
+}
+
+void exibir_estatisticas(const EstatisticasGrupo *est) {
+    printf("\n======== ESTATISTICAS: %s (%d aluno(s)) ========\n", est->rotulo, est->alunos);
+    if (est->alunos == 0) {
+        printf("[AVISO] Sem alunos para calcular estatisticas.\n");
+        return;
+    }
+    for (int k = 0; k < EST_DISCIPLINAS; k++) {
+        const Acumulador *anual = &est->disc[k][EST_ANUAL];
+        if (anual->n == 0) continue;
+        printf("%s\n", DISCIPLINAS_ESTATISTICA[k]);
+        char rotulo[8];
+        for (int u = 0; u < 4; u++) {
+            sprintf(rotulo, "U%d", u + 1);
+            exibir_linha_acumulador(rotulo, &est->disc[k][u]);
+        }
+        exibir_linha_acumulador("Anual", anual);
+        // Histograma 0-10 por ponto inteiro, somando as faixas de 0.1
+        printf("   Histograma anual:");
+        for (int p = 0; p < 10; p++) {
+            uint32_t qtd = 0;
+            for (int i = p * 10; i < (p + 1) * 10; i++) qtd += anual->faixas[i];
+            printf(" %d-%d:%u", p, p + 1, qtd);
+        }
+        printf("\n");
+    }
+    printf("===================================================\n");
+}
+
+/* Estatísticas por série e da escola inteira: cada turma é varrida uma
+   única vez e os resultados parciais são combinados. */
+void exibir_estatisticas_escola(Turma *lista_turmas) {
+    if (!lista_turmas) { printf("[ERRO] Nenhuma turma disponivel.\n"); return; }
+    EstatisticasGrupo *series = (EstatisticasGrupo*) calloc(13, sizeof(EstatisticasGrupo));
+    EstatisticasGrupo *escola = (EstatisticasGrupo*) calloc(1, sizeof(EstatisticasGrupo));
+    EstatisticasGrupo *parcial = (EstatisticasGrupo*) malloc(sizeof(EstatisticasGrupo));
+    if (!series || !escola || !parcial) {
+        free(series); free(escola); free(parcial);
+        printf("[ERRO] Memoria insuficiente.\n");
+        return;
+    }
+    for (Turma *t = lista_turmas; t; t = t->proximo_turma) {
+        if (t->serie < 1 || t->serie > 12) continue;
+        coletar_estatisticas_turma(t, parcial);
+        combinar_estatisticas(&series[t->serie], parcial);
+        combinar_estatisticas(escola, parcial);
+    }
+    for (int s = 1; s <= 12; s++) {
+        if (series[s].alunos == 0) continue;
+        snprintf(series[s].rotulo, sizeof(series[s].rotulo), "Serie %d", s);
+        exibir_estatisticas(&series[s]);
+    }
+    snprintf(escola->rotulo, sizeof(escola->rotulo), "Escola");
+    exibir_estatisticas(escola);
+    free(series);
+    free(escola);
+    free(parcial);
+}
+
+/* ==========================================================================
+   IMPORTAÇÃO EM LOTE (PARSER PARALELO POR BLOCOS)
+   ========================================================================== */
+
+/* Formato do arquivo (uma linha por registro, campos separados por ';'):
+     A;matricula;nome;serie                     -> matrícula
+     N;matricula;disciplina;unidade;prova;nota  -> lançamento de nota
+   Linhas vazias ou iniciadas por '#' são ignoradas.
+
+   O arquivo é mapeado em memória e dividido em blocos em fronteiras de
+   linha. Cada thread interpreta o seu bloco num lote local: matrículas já
+   viram Aluno com grade alocada, notas viram registros de 24 bytes que
+   apontam para o texto mapeado (sem cópia). Depois, uma única fase de
+   aplicação percorre os lotes na ordem do arquivo e insere nas turmas com
+   as mesmas regras de processar_matricula_turma (limite de vagas e fila). */
+
+#define IMPORT_MAX_THREADS    16
+#define IMPORT_BLOCO_MINIMO   (64 * 1024)   // Abaixo disso não vale abrir outra thread
+#define IMPORT_MAX_ERROS      10            // Erros guardados para exibição
+
+typedef struct {
+    uint32_t linha;          // Linha dentro do bloco (1-based)
+    uint8_t  tipo;           // 'A' ou 'N'
+    uint8_t  unidade, prova;
+    uint8_t  tam_matricula, tam_disciplina;
+    Nota     nota;
+    uint32_t off_matricula;  // Deslocamentos no arquivo mapeado
+    uint32_t off_disciplina;
+    Aluno   *aluno;          // Pré-construído (tipo 'A')
+} RegistroImportacao;
+
+typedef struct {
+    long        linha;       // Linha no arquivo
+    const char *motivo;
+} ErroImportacao;
+
+typedef struct {
+    const char *base;        // Início do arquivo mapeado
+    size_t inicio, fim;      // Faixa deste bloco
+    RegistroImportacao *registros;
+    int qtd, cap;
+    uint32_t linhas;
+    int qtd_erros;
+    ErroImportacao erros[IMPORT_MAX_ERROS]; // 'linha' ainda relativa ao bloco
+    int total_erros;
+} LoteImportacao;
+
+typedef struct {
+    long linhas;
+    int  matriculados, em_fila, notas, duplicados, erros, threads;
+    double segundos_leitura, segundos_aplicacao;
+    int qtd_erros;
+    ErroImportacao primeiros_erros[IMPORT_MAX_ERROS];
+} ResumoImportacao;
+
+static double relogio_segundos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void lote_erro(LoteImportacao *l, uint32_t linha, const char *motivo) {
+    l->total_erros++;
+    if (l->qtd_erros < IMPORT_MAX_ERROS) {
+        l->erros[l->qtd_erros].linha = linha;
+        l->erros[l->qtd_erros].motivo = motivo;
+        l->qtd_erros++;
+    }
+}
+
+static RegistroImportacao* lote_novo_registro(LoteImportacao *l) {
+    if (l->qtd == l->cap) {
+        int nova_cap = l->cap ? l->cap * 2 : 1024;
+        RegistroImportacao *novo = (RegistroImportacao*) realloc(l->registros, nova_cap * sizeof(RegistroImportacao));
+        if (!novo) return NULL;
+        l->registros = novo;
+        l->cap = nova_cap;
+    }
+    return &l->registros[l->qtd++];
+}
+
+/* Inteiro sem sinal a partir de [p, fim); -1 se vazio ou inválido. */
+static int ler_inteiro_campo(const char *p, const char *fim) {
+    if (p == fim) return -1;
+    int v = 0;
+    for (; p < fim; p++) {
+        if (*p < '0' || *p > '9' || v > 100000) return -1;
+        v = v * 10 + (*p - '0');
+    }
+    return v;
+}
+
+/* Nota "d", "d.d" ou "d.dd" (ponto ou vírgula) direto em centésimos. */
+static int ler_nota_campo(const char *p, const char *fim) {
+    int inteiro = 0, centesimos = 0, casas = 0, digitos = 0, na_fracao = 0;
+    for (; p < fim; p++) {
+        if (*p == '.' || *p == ',') { if (na_fracao) return -1; na_fracao = 1; continue; }
+        if (*p < '0' || *p > '9') return -1;
+        if (!na_fracao) { inteiro = inteiro * 10 + (*p - '0'); if (inteiro > 10) return -1; }
+        else if (casas < 2) { centesimos = centesimos * 10 + (*p - '0'); casas++; }
+        else return -1;
+        digitos++;
+    }
+    if (!digitos) return -1;
+    if (casas == 1) centesimos *= 10;
+    int v = inteiro * NOTA_ESCALA + centesimos;
+    return (v > NOTA_MAXIMA) ? -1 : v;
+}
+
+/* Thread de leitura: interpreta as linhas do bloco [inicio, fim). */
+static void* interpretar_bloco(void *arg) {
+    rastreio_nomear_thread("importacao");
+    RASTREAR("interpretar_bloco");
+    LoteImportacao *l = (LoteImportacao*) arg;
+    const char *p = l->base + l->inicio;
+    const char *limite = l->base + l->fim;
+    while (p < limite) {
+        const char *eol = memchr(p, '\n', (size_t)(limite - p));
+        if (!eol) eol = limite;
+        const char *fim_linha = (eol > p && eol[-1] == '\r') ? eol - 1 : eol;
+        uint32_t linha = ++l->linhas;
+
+        // Separa os campos (no máximo 6)
+        const char *campo[6], *fim_campo[6];
+        int qtd = 0;
+        const char *c = p;
+        while (qtd < 6) {
+            const char *sep = memchr(c, ';', (size_t)(fim_linha - c));
+            campo[qtd] = c;
+            fim_campo[qtd] = sep ? sep : fim_linha;
+            qtd++;
+            if (!sep) break;
+            c = sep + 1;
+        }
+
+        if (fim_linha == p || *p == '#') {
+            // Linha vazia ou comentário
+        } else if (*p == 'A' && fim_campo[0] - campo[0] == 1) {
+            int serie = (qtd == 4) ? ler_inteiro_campo(campo[3], fim_campo[3]) : -1;
+            size_t tam_mat = fim_campo[1] - campo[1], tam_nome = fim_campo[2] - campo[2];
+            if (qtd != 4) lote_erro(l, linha, "matricula: esperado A;matricula;nome;serie");
+            else if (serie < 1 || serie > 12) lote_erro(l, linha, "serie fora de 1-12");
+            else if (tam_mat == 0 || tam_mat >= 20) lote_erro(l, linha, "matricula vazia ou longa demais");
+            else if (tam_nome == 0 || tam_nome >= 100) lote_erro(l, linha, "nome vazio ou longo demais");
+            else {
+                char mat[20], nome[100];
+                memcpy(mat, campo[1], tam_mat);   mat[tam_mat] = '\0';
+                memcpy(nome, campo[2], tam_nome); nome[tam_nome] = '\0';
+                RegistroImportacao *r = lote_novo_registro(l);
+                Aluno *a = r ? matricular_aluno(mat, nome, serie) : NULL;
+                if (!a) { if (r) l->qtd--; lote_erro(l, linha, "memoria insuficiente"); }
+                else {
+                    r->linha = linha;
+                    r->tipo = 'A';
+                    r->aluno = a;
+                }
+            }
+        } else if (*p == 'N' && fim_campo[0] - campo[0] == 1) {
+            int unidade = (qtd == 6) ? ler_inteiro_campo(campo[3], fim_campo[3]) : -1;
+            int prova   = (qtd == 6) ? ler_inteiro_campo(campo[4], fim_campo[4]) : -1;
+            int nota    = (qtd == 6) ? ler_nota_campo(campo[5], fim_campo[5]) : -1;
+            size_t tam_mat = fim_campo[1] - campo[1], tam_disc = fim_campo[2] - campo[2];
+            if (qtd != 6) lote_erro(l, linha, "nota: esperado N;matricula;disciplina;unidade;prova;nota");
+            else if (unidade < 1 || unidade > 4) lote_erro(l, linha, "unidade fora de 1-4");
+            else if (prova != 1 && prova != 2) lote_erro(l, linha, "prova deve ser 1 ou 2");
+            else if (nota < 0) lote_erro(l, linha, "nota invalida (0.00 a 10.00)");
+            else if (tam_mat == 0 || tam_mat >= 20 || tam_disc == 0 || tam_disc >= 50)
+                lote_erro(l, linha, "matricula/disciplina vazia ou longa demais");
+            else {
+                RegistroImportacao *r = lote_novo_registro(l);
+                if (!r) lote_erro(l, linha, "memoria insuficiente");
+                else {
+                    r->linha = linha;
+                    r->tipo = 'N';
+                    r->unidade = (uint8_t) unidade;
+                    r->prova = (uint8_t) prova;
+                    r->nota = (Nota) nota;
+                    r->off_matricula = (uint32_t)(campo[1] - l->base);
+                    r->tam_matricula = (uint8_t) tam_mat;
+                    r->off_disciplina = (uint32_t)(campo[2] - l->base);
+                    r->tam_disciplina = (uint8_t) tam_disc;
+                }
+            }
+        } else {
+            lote_erro(l, linha, "tipo de registro desconhecido (use A ou N)");
+        }
+        p = eol + 1;
+    }
+    return NULL;
+}
+
+/* Tabela hash matrícula -> Aluno (endereçamento aberto) usada na aplicação. */
+typedef struct {
+    Aluno **slots;
+    size_t mascara;
+} MapaMatriculas;
+
+static Aluno** mapa_slot(MapaMatriculas *m, const char *mat, size_t tam) {
+    size_t i = hash_matricula(mat, tam) & m->mascara;
+    while (m->slots[i]) {
+        if (strlen(m->slots[i]->matricula) == tam && memcmp(m->slots[i]->matricula, mat, tam) == 0)
+            return &m->slots[i];
+        i = (i + 1) & m->mascara;
+    }
+    return &m->slots[i];
+}
+
+static int comparar_erros_importacao(const void *x, const void *y) {
+    long a = ((const ErroImportacao*) x)->linha, b = ((const ErroImportacao*) y)->linha;
+    return (a > b) - (a < b);
+}
+
+/* Fase de aplicação: lotes na ordem do arquivo, na thread principal. */
+static void aplicar_lotes(LoteImportacao *lotes, int qtd_lotes, Turma **lista_turmas,
+                          FilaEspera *f, ResumoImportacao *res) {
+    RASTREAR("aplicar_lotes");
+    size_t previstos = 16;
+    for (Turma *t = *lista_turmas; t; t = t->proximo_turma) previstos += t->qtd_atual;
+    previstos += f->quantidade;
+    for (int i = 0; i < qtd_lotes; i++) previstos += lotes[i].qtd;
+    size_t cap = 1;
+    while (cap < previstos * 2) cap <<= 1;
+    MapaMatriculas mapa = { (Aluno**) calloc(cap, sizeof(Aluno*)), cap - 1 };
+    if (!mapa.slots) { res->erros++; return; }
+
+    for (Turma *t = *lista_turmas; t; t = t->proximo_turma)
+        for (Aluno *a = t->lista_alunos; a; a = a->proximo)
+            *mapa_slot(&mapa, a->matricula, strlen(a->matricula)) = a;
+    for (int sr = 1; sr < FILA_SERIES; sr++)
+        for (int i = 0; i < f->series[sr].qtd; i++) {
+            Aluno *a = f->series[sr].itens[i];
+            *mapa_slot(&mapa, a->matricula, strlen(a->matricula)) = a;
+        }
+
+    // Alunos novos entram no indice de nomes de uma vez, ao final
+    int qtd_novos = 0;
+    Aluno **novos = (Aluno**) malloc((previstos + 1) * sizeof(Aluno*));
+
+    long linha_base = 0;
+    for (int i = 0; i < qtd_lotes; i++) {
+        LoteImportacao *l = &lotes[i];
+        for (int e = 0; e < l->qtd_erros && res->qtd_erros < IMPORT_MAX_ERROS; e++) {
+            res->primeiros_erros[res->qtd_erros].linha = linha_base + l->erros[e].linha;
+            res->primeiros_erros[res->qtd_erros].motivo = l->erros[e].motivo;
+            res->qtd_erros++;
+        }
+        res->erros += l->total_erros;
+
+        for (int k = 0; k < l->qtd; k++) {
+            RegistroImportacao *r = &l->registros[k];
+            const char *motivo = NULL;
+            if (r->tipo == 'A') {
+                Aluno *a = r->aluno;
+                Aluno **slot = mapa_slot(&mapa, a->matricula, strlen(a->matricula));
+                if (*slot) {
+                    deletar_aluno(a);
+                    res->duplicados++;
+                    motivo = "matricula ja existente";
+                } else {
+                    *slot = a;
+                    Turma *t = buscar_turma_serie(*lista_turmas, a->serie);
+                    if (!t) t = criar_turma_serie(lista_turmas, a->serie);
+                    if (t && t->qtd_atual < t->limite_vagas) {
+                        anexar_aluno_turma(t, a);
+                        res->matriculados++;
+                    } else if (inserir_fila(f, a) > 0) {
+                        res->em_fila++;
+                    } else if (t) {
+                        // Sem como entrar na fila: não perde o aluno, excede o limite da turma
+                        anexar_aluno_turma(t, a);
+                        res->matriculados++;
+                        motivo = "fila de espera indisponivel: turma acima do limite";
+                    } else {
+                        /* Nem turma nem fila: o aluno não pertence a ninguém. O slot
+                           acabou de ser ocupado (nada foi sondado depois), então
+                           limpá-lo devolve o mapa ao estado anterior. */
+                        *slot = NULL;
+                        deletar_aluno(a);
+                        res->erros++;
+                        motivo = "sem turma nem fila de espera (memoria insuficiente)";
+                        a = NULL;
+                    }
+                    if (a) {
+                        if (novos) novos[qtd_novos++] = a;
+                        else indice_inserir(ENTRADA_ALUNO, a, a->nome);
+                    }
+                }
+            } else {
+                Aluno **slot = mapa_slot(&mapa, l->base + r->off_matricula, r->tam_matricula);
+                Disciplina *d = NULL;
+                if (*slot) {
+                    for (d = (*slot)->lista_disciplinas; d; d = d->proximo)
+                        if (strlen(d->nome) == r->tam_disciplina &&
+                            memcmp(d->nome, l->base + r->off_disciplina, r->tam_disciplina) == 0) break;
+                }
+                if (!*slot) motivo = "aluno nao encontrado";
+                else if (!d) motivo = "disciplina fora da grade do aluno";
+                else {
+                    gravar_nota(*slot, d, r->unidade - 1, r->prova, r->nota);
+                    res->notas++;
+                }
+            }
+            if (motivo) {
+                if (r->tipo == 'N') res->erros++;
+                if (res->qtd_erros < IMPORT_MAX_ERROS) {
+                    res->primeiros_erros[res->qtd_erros].linha = linha_base + r->linha;
+                    res->primeiros_erros[res->qtd_erros].motivo = motivo;
+                    res->qtd_erros++;
+                }
+            }
+        }
+        linha_base += l->linhas;
+    }
+    res->linhas = linha_base;
+    qsort(res->primeiros_erros, res->qtd_erros, sizeof(ErroImportacao), comparar_erros_importacao);
+    indice_inserir_alunos_lote(novos, qtd_novos);
+    free(novos);
+    free(mapa.slots);
+}
+
+/* Importa o arquivo. Retorna 0 se não foi possível abri-lo/mapeá-lo. */
+int importar_arquivo(const char *caminho, Turma **lista_turmas, FilaEspera *f, ResumoImportacao *res) {
+    RASTREAR("importar_arquivo");
+    memset(res, 0, sizeof(ResumoImportacao));
+    double t0 = relogio_segundos();
+
+#ifdef _WIN32
+    FILE *fp = fopen(caminho, "rb");
+    if (!fp) return 0;
+    fseek(fp, 0, SEEK_END);
+    long tam_arquivo = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *dados = (char*) malloc(tam_arquivo > 0 ? (size_t) tam_arquivo : 1);
+    size_t tamanho = dados ? fread(dados, 1, (size_t) tam_arquivo, fp) : 0;
+    fclose(fp);
+    if (!dados) return 0;
+#else
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); return 0; }
+    size_t tamanho = (size_t) st.st_size;
+    char *dados = NULL;
+    if (tamanho > 0) {
+        dados = (char*) mmap(NULL, tamanho, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (dados == MAP_FAILED) { close(fd); return 0; }
+#ifdef MADV_SEQUENTIAL
+        madvise(dados, tamanho, MADV_SEQUENTIAL);
+#endif
+    }
+    close(fd);
+#endif
+    if (tamanho >= UINT32_MAX) {
+        // Deslocamentos dos registros são de 32 bits
+#ifdef _WIN32
+        free(dados);
+#else
+        munmap(dados, tamanho);
+#endif
+        return 0;
+    }
+
+    // Quantos blocos: um por núcleo, sem blocos menores que IMPORT_BLOCO_MINIMO
+    long nucleos = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+    nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    int qtd_lotes = (int)(tamanho / IMPORT_BLOCO_MINIMO) + 1;
+    if (qtd_lotes > nucleos) qtd_lotes = (int) nucleos;
+    if (qtd_lotes > IMPORT_MAX_THREADS) qtd_lotes = IMPORT_MAX_THREADS;
+    if (qtd_lotes < 1) qtd_lotes = 1;
+
+    LoteImportacao *lotes = (LoteImportacao*) calloc(qtd_lotes, sizeof(LoteImportacao));
+    pthread_t threads[IMPORT_MAX_THREADS];
+    size_t inicio = 0;
+    for (int i = 0; i < qtd_lotes && lotes; i++) {
+        size_t fim = (i == qtd_lotes - 1) ? tamanho : tamanho / qtd_lotes * (i + 1);
+        if (fim < inicio) fim = inicio;
+        // Avança até o fim da linha para nunca cortar um registro
+        while (fim > 0 && fim < tamanho && dados[fim - 1] != '\n') fim++;
+        lotes[i].base = dados;
+        lotes[i].inicio = inicio;
+        lotes[i].fim = fim;
+        inicio = fim;
+    }
+    int criada[IMPORT_MAX_THREADS] = {0};
+    for (int i = 1; i < qtd_lotes && lotes; i++)
+        criada[i] = (pthread_create(&threads[i], NULL, interpretar_bloco, &lotes[i]) == 0);
+    if (lotes) interpretar_bloco(&lotes[0]); // A thread principal cuida do primeiro bloco
+    for (int i = 1; i < qtd_lotes && lotes; i++) {
+        if (criada[i]) pthread_join(threads[i], NULL);
+        else interpretar_bloco(&lotes[i]);     // Sem thread disponível: lê aqui mesmo
+    }
+    res->threads = qtd_lotes;
+
+    double t1 = relogio_segundos();
+    if (lotes) aplicar_lotes(lotes, qtd_lotes, lista_turmas, f, res);
+    double t2 = relogio_segundos();
+    res->segundos_leitura = t1 - t0;
+    res->segundos_aplicacao = t2 - t1;
+
+    for (int i = 0; i < qtd_lotes && lotes; i++) free(lotes[i].registros);
+    free(lotes);
+#ifdef _WIN32
+    free(dados);
+#else
+    if (dados) munmap(dados, tamanho);
+#endif
+    return 1;
+}
+
+/* ==========================================================================
+   REDE DE CAMPI (VÁRIAS ESCOLAS NO MESMO PROCESSO)
+   ========================================================================== */
+
+/* Cada campus é uma escola independente: suas turmas, professores, fila de
+   espera e pilha de desfazer. Consultas da rede inteira rodam uma thread
+   por campus produzindo um resultado parcial, e os parciais são combinados
+   na thread principal. Invariante: as tarefas de campus só leem. media_final
+   e os totais de professores e departamentos são mantidos na escrita, na
+   thread principal; calcular_media_aluno e aluno_aprovado são leituras
+   puras. Nada nesses caminhos pode chamar reavaliar_*: reavaliar_disciplina
+   escreve nos totais de Professor e Departamento, que são compartilhados
+   entre campi (departamentos é um registro global). */
+
+typedef struct Campus {
+    char nome[50];
+    Turma *lista_turmas;
+    Professor *lista_professores;
+    FilaEspera *espera;
+    Pilha *seguranca;
+} Campus;
+
+typedef struct {
+    Campus **campi;
+    int qtd, cap;
+} RedeEscolar;
+
+Campus* criar_campus(const char *nome) {
+    Campus *c = (Campus*) calloc(1, sizeof(Campus));
+    if (!c) return NULL;
+    snprintf(c->nome, sizeof(c->nome), "%s", nome);
+    c->espera = criar_fila();
+    c->seguranca = criarPilha();
+    if (!c->espera || !c->seguranca) {
+        free(c->espera);
+        free(c->seguranca);
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+int adicionar_campus(RedeEscolar *r, Campus *c) {
+    if (!c) return 0;
+    if (r->qtd == r->cap) {
+        int nova_cap = r->cap ? r->cap * 2 : 4;
+        Campus **novo = (Campus**) realloc(r->campi, nova_cap * sizeof(Campus*));
+        if (!novo) return 0;
+        r->campi = novo;
+        r->cap = nova_cap;
+    }
+    r->campi[r->qtd++] = c;
+    return 1;
+}
+
+Campus* buscar_campus(RedeEscolar *r, const char *nome) {
+    for (int i = 0; i < r->qtd; i++)
+        if (strcmp(r->campi[i]->nome, nome) == 0) return r->campi[i];
+    return NULL;
+}
+
+/* --- Busca por nome no campus ---
+   As entradas do indice de nomes nao guardam o campus; ele e conferido na
+   consulta: aluno numa turma do campus ou na fila de espera dele, professor
+   do cadastro dele. Turmas de campi diferentes podem ter o mesmo codigo. */
+static int campus_contem_aluno(const Campus *c, const Aluno *a) {
+    if (a->turma) {
+        for (const Turma *t = c->lista_turmas; t; t = t->proximo_turma)
+            if (t == a->turma) return 1;
+        return 0;
+    }
+    const FilaEspera *f = c->espera;
+    if (!f || a->posicao_fila < 0 || a->serie < 1 || a->serie >= FILA_SERIES) return 0;
+    const HeapFila *h = &f->series[a->serie];
+    return a->posicao_fila < h->qtd && h->itens[a->posicao_fila] == a;
+}
+
+static int campus_contem_professor(const Campus *c, const Professor *p) {
+    for (const Professor *atual = c->lista_professores; atual; atual = atual->proximo)
+        if (atual == p) return 1;
+    return 0;
+}
+
+/* Preenche 'resultado' com ate 'max' entradas do campus cujo nome comeca
+   com o prefixo (em ordem alfabetica). Retorna quantas foram encontradas. */
+int buscar_por_nome(const Campus *c, const char *prefixo, EntradaNome *resultado, int max) {
+    RASTREAR("buscar_por_nome");
+    char chave[100];
+    normalizar_nome(chave, sizeof(chave), prefixo);
+    size_t tam = strlen(chave);
+    int qtd = 0;
+    for (int i = indice_limite_inferior(chave);
+         i < indice_nomes.qtd && qtd < max && strncmp(indice_nomes.itens[i].chave, chave, tam) == 0; i++) {
+        const EntradaNome *e = &indice_nomes.itens[i];
+        int do_campus = (e->tipo == ENTRADA_ALUNO) ? campus_contem_aluno(c, (const Aluno*) e->ref)
+                                                   : campus_contem_professor(c, (const Professor*) e->ref);
+        if (do_campus) resultado[qtd++] = *e;
+    }
+    return qtd;
+}
+
+void exibir_busca_nome(const Campus *c, const char *prefixo) {
+    EntradaNome resultado[BUSCA_MAX_RESULTADOS];
+    int qtd = buscar_por_nome(c, prefixo, resultado, BUSCA_MAX_RESULTADOS);
+    if (qtd == 0) {
+        printf("[INFO] Nenhum nome comeca com '%s' no campus %s.\n", prefixo, c->nome);
+        return;
+    }
+    printf("\n--- RESULTADOS PARA '%s' NO CAMPUS %s (%d) ---\n", prefixo, c->nome, qtd);
+    for (int i = 0; i < qtd; i++) {
+        if (resultado[i].tipo == ENTRADA_ALUNO) {
+            Aluno *a = (Aluno*) resultado[i].ref;
+            printf("Aluno     | %-25s | Mat: %-12s | Turma: %s\n", a->nome, a->matricula,
+                   a->turma ? a->turma->codigo : "(fila de espera)");
+        } else {
+            Professor *p = (Professor*) resultado[i].ref;
+            printf("Professor | %-25s | ID: %-13s | Depto: %s\n", p->nome, p->id, p->departamento);
+        }
+    }
+}
+
+/* A regra de uma serie vale para a rede inteira: grava uma vez e recalcula,
+   em todos os campi, as turmas da serie sem regra propria e os candidatos
+   da fila de espera dessa serie (que tambem seguem a regra da serie). */
+int definir_plano_serie_rede(RedeEscolar *r, int serie, const PlanoAvaliacao *plano) {
+    if (!guardar_plano_serie(serie, plano)) return 0;
+    int qtd = 0;
+    for (int i = 0; i < r->qtd; i++) {
+        qtd += reavaliar_serie(r->campi[i]->lista_turmas, serie);
+        FilaEspera *f = r->campi[i]->espera;
+        if (!f || serie < 1 || serie >= FILA_SERIES) continue;
+        for (int k = 0; k < f->series[serie].qtd; k++, qtd++) {
+            reavaliar_aluno(f->series[serie].itens[k]);
+            marcar_aluno_alterado(f->series[serie].itens[k]);
+        }
+    }
+    return qtd;
+}
+
+/* --- Execução paralela por campus --- */
+
+typedef void (*TarefaCampus)(Campus *c, void *parcial, const void *arg);
+
+typedef struct {
+    TarefaCampus tarefa;
+    Campus *campus;
+    void *parcial;
+    const void *arg;
+} TrabalhoCampus;
+
+static void* executar_trabalho_campus(void *p) {
+    rastreio_nomear_thread("campus");
+    RASTREAR("tarefa_campus");
+    TrabalhoCampus *t = (TrabalhoCampus*) p;
+    t->tarefa(t->campus, t->parcial, t->arg);
+    return NULL;
+}
+
+/* Roda 'tarefa' em todos os campi em paralelo. 'parciais' é um vetor com
+   r->qtd resultados de 'tam_parcial' bytes, um por campus, na ordem da rede. */
+static void executar_em_paralelo(RedeEscolar *r, TarefaCampus tarefa, void *parciais,
+                                 size_t tam_parcial, const void *arg) {
+    RASTREAR("executar_em_paralelo");
+    TrabalhoCampus *trabalhos = (TrabalhoCampus*) malloc(r->qtd * sizeof(TrabalhoCampus));
+    pthread_t *threads = (pthread_t*) malloc(r->qtd * sizeof(pthread_t));
+    int *criada = (int*) calloc(r->qtd, sizeof(int));
+    if (!trabalhos || !threads || !criada) {
+        // Sem memória para as threads: executa em sequência
+        for (int i = 0; i < r->qtd; i++)
+            tarefa(r->campi[i], (char*) parciais + i * tam_parcial, arg);
+    } else {
+        for (int i = 0; i < r->qtd; i++) {
+            trabalhos[i].tarefa = tarefa;
+            trabalhos[i].campus = r->campi[i];
+            trabalhos[i].parcial = (char*) parciais + i * tam_parcial;
+            trabalhos[i].arg = arg;
+            criada[i] = (pthread_create(&threads[i], NULL, executar_trabalho_campus, &trabalhos[i]) == 0);
+            if (!criada[i]) executar_trabalho_campus(&trabalhos[i]);
+        }
+        for (int i = 0; i < r->qtd; i++)
+            if (criada[i]) pthread_join(threads[i], NULL);
+    }
+    free(trabalhos);
+    free(threads);
+    free(criada);
+}
+
+/* --- Taxa de aprovação --- */
+
+typedef struct {
+    int aprovados[13];
+    int total[13];
+} AprovacaoParcial;
+
+static void tarefa_aprovacao(Campus *c, void *parcial, const void *arg) {
+    (void) arg;
+    AprovacaoParcial *p = (AprovacaoParcial*) parcial;
+    memset(p, 0, sizeof(AprovacaoParcial));
+    for (Turma *t = c->lista_turmas; t; t = t->proximo_turma) {
+        if (t->serie < 1 || t->serie > 12) continue;
+        for (Aluno *a = t->lista_alunos; a; a = a->proximo) {
+            p->total[t->serie]++;
+            if (aluno_aprovado(a)) p->aprovados[t->serie]++;
+        }
+    }
+}
+
+void exibir_aprovacao_rede(RedeEscolar *r) {
+    AprovacaoParcial *parciais = (AprovacaoParcial*) calloc(r->qtd, sizeof(AprovacaoParcial));
+    if (!parciais) return;
+    executar_em_paralelo(r, tarefa_aprovacao, parciais, sizeof(AprovacaoParcial), NULL);
+
+    AprovacaoParcial rede;
+    memset(&rede, 0, sizeof(rede));
+    printf("\n======== APROVACAO NA REDE (%d campi) ========\n", r->qtd);
+    for (int i = 0; i < r->qtd; i++) {
+        int apr = 0, tot = 0;
+        for (int s = 1; s <= 12; s++) {
+            apr += parciais[i].aprovados[s];
+            tot += parciais[i].total[s];
+            rede.aprovados[s] += parciais[i].aprovados[s];
+            rede.total[s] += parciais[i].total[s];
+        }
+        printf("%-20s | Aprovados: %5d / %5d | Taxa: %5.1f%%\n", r->campi[i]->nome, apr, tot,
+               tot ? 100.0f * apr / tot : 0.0f);
+    }
+    printf("--- Por serie (rede) ---\n");
+    int apr = 0, tot = 0;
+    for (int s = 1; s <= 12; s++) {
+        if (!rede.total[s]) continue;
+        apr += rede.aprovados[s];
+        tot += rede.total[s];
+        printf("Serie %2d            | Aprovados: %5d / %5d | Taxa: %5.1f%%\n", s,
+               rede.aprovados[s], rede.total[s], 100.0f * rede.aprovados[s] / rede.total[s]);
+    }
+    printf("REDE                | Aprovados: %5d / %5d | Taxa: %5.1f%%\n", apr, tot,
+           tot ? 100.0f * apr / tot : 0.0f);
+    printf("===============================================\n");
+    free(parciais);
+}
+
+/* --- Localização por matrícula --- */
+
+typedef struct {
+    Aluno *aluno;
+    Turma *turma;        // NULL se o aluno está na fila de espera
+} LocalizacaoParcial;
+
+static void tarefa_localizar(Campus *c, void *parcial, const void *arg) {
+    LocalizacaoParcial *p = (LocalizacaoParcial*) parcial;
+    const char *mat = (const char*) arg;
+    p->aluno = NULL;
+    p->turma = NULL;
+    for (Turma *t = c->lista_turmas; t; t = t->proximo_turma) {
+        Aluno *a = buscar_aluno(t->lista_alunos, (char*) mat);
+        if (a) { p->aluno = a; p->turma = t; return; }
+    }
+    p->aluno = buscar_fila(c->espera, mat);
+}
+
+/* Procura a matrícula em todos os campi em paralelo. Retorna o campus
+   (o primeiro na ordem da rede, se houver repetição) ou NULL. */
+Campus* localizar_aluno_rede(RedeEscolar *r, const char *mat, Aluno **aluno, Turma **turma) {
+    RASTREAR("localizar_aluno_rede");
+    LocalizacaoParcial *parciais = (LocalizacaoParcial*) calloc(r->qtd, sizeof(LocalizacaoParcial));
+    if (!parciais) return NULL;
+    executar_em_paralelo(r, tarefa_localizar, parciais, sizeof(LocalizacaoParcial), mat);
+    Campus *achado = NULL;
+    for (int i = 0; i < r->qtd && !achado; i++) {
+        if (!parciais[i].aluno) continue;
+        achado = r->campi[i];
+        *aluno = parciais[i].aluno;
+        *turma = parciais[i].turma;
+    }
+    free(parciais);
+    return achado;
+}
+
+/* --- Estatísticas de uma série --- */
+
+static void tarefa_estatisticas_serie(Campus *c, void *parcial, const void *arg) {
+    EstatisticasGrupo *p = (EstatisticasGrupo*) parcial;
+    int serie = *(const int*) arg;
+    EstatisticasGrupo *turma = (EstatisticasGrupo*) malloc(sizeof(EstatisticasGrupo));
+    memset(p, 0, sizeof(EstatisticasGrupo));
+    if (!turma) return;
+    for (Turma *t = c->lista_turmas; t; t = t->proximo_turma) {
+        if (t->serie != serie) continue;
+        coletar_estatisticas_turma(t, turma);
+        combinar_estatisticas(p, turma);
+    }
+    free(turma);
+}
+
+void exibir_estatisticas_serie_rede(RedeEscolar *r, int serie) {
+    EstatisticasGrupo *parciais = (EstatisticasGrupo*) calloc(r->qtd, sizeof(EstatisticasGrupo));
+    EstatisticasGrupo *rede = (EstatisticasGrupo*) calloc(1, sizeof(EstatisticasGrupo));
+    if (!parciais || !rede) { free(parciais); free(rede); return; }
+    executar_em_paralelo(r, tarefa_estatisticas_serie, parciais, sizeof(EstatisticasGrupo), &serie);
+    for (int i = 0; i < r->qtd; i++) combinar_estatisticas(rede, &parciais[i]);
+    snprintf(rede->rotulo, sizeof(rede->rotulo), "Rede - Serie %d", serie);
+    exibir_estatisticas(rede);
+    free(parciais);
+    free(rede);
+}
+
+/* ==========================================================================
+   ARQUIVO DE ANOS ENCERRADOS (COLUNAR, COMPRIMIDO, CARGA SOB DEMANDA)
+   ========================================================================== */
+
+/* Antes da promoção, o ano fechado pode ser congelado num arquivo compacto:
+   os alunos (ordenados por matrícula) são gravados em blocos de
+   ARQ_BLOCO_ALUNOS, e dentro de cada bloco os dados ficam em colunas:
+     - matrículas com prefixo compartilhado (front coding);
+     - turma, disciplinas e professores como índices de um dicionário único;
+     - notas em centésimos como varint, com corridas de zeros colapsadas;
+     - media_final de cada disciplina, média geral, frequência (milésimos)
+       e média de aprovação da regra vigente, calculadas no arquivamento.
+   Layout: [cabeçalho][blocos...][dicionário][índice de blocos].
+   Consultas de boletim buscam o bloco pelo índice (busca binária pela
+   primeira matrícula) e só leem do disco os blocos que faltam no cache LRU
+   de ARQ_CACHE_BLOCOS blocos decodificados. */
+
+#define ARQ_MAGICO        "KARQ"
+#define ARQ_VERSAO        3           // 2: coluna de frequência; 3: média de aprovação
+#define ARQ_VERSAO_MINIMA 1           // Anos congelados por versões anteriores continuam legíveis
+#define ARQ_BLOCO_ALUNOS  128
+#define ARQ_CACHE_BLOCOS  8
+#define ARQ_CABECALHO     32          // Bytes do cabeçalho fixo
+#define ARQ_NOME_PADRAO   "kolping_%s_%d.arq"   // Campus, ano
+
+/* Caminho do arquivo do ano de um campus. No nome do campus, o que não for
+   [A-Za-z0-9_-] vira '_' (espaços, acentos, barras). */
+void caminho_arquivo_ano(char *dst, size_t cap, const char *campus, int ano) {
+    char nome[50];
+    size_t n = 0;
+    for (; campus[n] && n < sizeof(nome) - 1; n++) {
+        char c = campus[n];
+        int valido = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                     c == '-' || c == '_';
+        nome[n] = valido ? c : '_';
+    }
+    nome[n] = '\0';
+    snprintf(dst, cap, ARQ_NOME_PADRAO, nome, ano);
+}
+
+typedef struct {
+    unsigned char *dados;
+    size_t tam, cap;
+} BufferArq;
+
+static int buf_reservar(BufferArq *b, size_t extra) {
+    if (b->tam + extra <= b->cap) return 1;
+    size_t nova_cap = b->cap ? b->cap : 4096;
+    while (nova_cap < b->tam + extra) nova_cap *= 2;
+    unsigned char *novo = (unsigned char*) realloc(b->dados, nova_cap);
+    if (!novo) return 0;
+    b->dados = novo;
+    b->cap = nova_cap;
+    return 1;
+}
+
+static void buf_bytes(BufferArq *b, const void *p, size_t n) {
+    if (!buf_reservar(b, n)) return;
+    memcpy(b->dados + b->tam, p, n);
+    b->tam += n;
+}
+
+static void buf_varint(BufferArq *b, uint32_t v) {
+    unsigned char tmp[5];
+    int n = 0;
+    do {
+        tmp[n] = (unsigned char) (v & 0x7F);
+        v >>= 7;
+        if (v) tmp[n] |= 0x80;
+        n++;
+    } while (v);
+    buf_bytes(b, tmp, n);
+}
+
+static void buf_texto(BufferArq *b, const char *s) {
+    size_t n = strlen(s);
+    buf_varint(b, (uint32_t) n);
+    buf_bytes(b, s, n);
+}
+
+// Inteiros de tamanho fixo em little-endian (o arquivo é portátil entre máquinas)
+static void buf_u32(BufferArq *b, uint32_t v) {
+    unsigned char tmp[4] = {(unsigned char) v, (unsigned char) (v >> 8),
+                            (unsigned char) (v >> 16), (unsigned char) (v >> 24)};
+    buf_bytes(b, tmp, 4);
+}
+
+static void buf_u64(BufferArq *b, uint64_t v) {
+    buf_u32(b, (uint32_t) v);
+    buf_u32(b, (uint32_t) (v >> 32));
+}
+
+typedef struct {
+    const unsigned char *p, *fim;
+    int ok;                     // Vira 0 ao ler além do fim (arquivo corrompido)
+} LeitorArq;
+
+static uint32_t ler_varint(LeitorArq *l) {
+    uint32_t v = 0;
+    for (int desloc = 0; desloc < 35; desloc += 7) {
+        if (l->p >= l->fim) { l->ok = 0; return 0; }
+        unsigned char c = *l->p++;
+        v |= (uint32_t) (c & 0x7F) << desloc;
+        if (!(c & 0x80)) return v;
+    }
+    l->ok = 0;
+    return 0;
+}
+
+static void ler_bytes(LeitorArq *l, void *dst, size_t n) {
+    if ((size_t) (l->fim - l->p) < n) { l->ok = 0; memset(dst, 0, n); return; }
+    memcpy(dst, l->p, n);
+    l->p += n;
+}
+
+// Lê uma string com tamanho prefixado para 'dst' (truncada em cap - 1)
+static void ler_texto(LeitorArq *l, char *dst, size_t cap) {
+    uint32_t n = ler_varint(l);
+    if ((size_t) (l->fim - l->p) < n) { l->ok = 0; dst[0] = '\0'; return; }
+    size_t copia = n < cap ? n : cap - 1;
+    memcpy(dst, l->p, copia);
+    dst[copia] = '\0';
+    l->p += n;
+}
+
+static uint32_t ler_u32(LeitorArq *l) {
+    unsigned char t[4];
+    ler_bytes(l, t, 4);
+    return (uint32_t) t[0] | (uint32_t) t[1] << 8 | (uint32_t) t[2] << 16 | (uint32_t) t[3] << 24;
+}
+
+static uint64_t ler_u64(LeitorArq *l) {
+    uint64_t baixo = ler_u32(l);
+    return baixo | (uint64_t) ler_u32(l) << 32;
+}
+
+/* --- Dicionário de strings (turmas, disciplinas, professores) --- */
+
+typedef struct {
+    char **itens;
+    int qtd, cap;
+    int *slots;                 // Hash aberto: índice + 1 (0 = vazio)
+    size_t mascara;
+} DicionarioArq;
+
+static int dicionario_id(DicionarioArq *d, const char *s) {
+    if ((size_t) (d->qtd + 1) * 2 > (d->slots ? d->mascara + 1 : 0)) {
+        size_t cap = d->slots ? (d->mascara + 1) * 2 : 64;
+        int *novo = (int*) calloc(cap, sizeof(int));
+        if (!novo) return -1;
+        for (int i = 0; i < d->qtd; i++) {
+            size_t j = hash_matricula(d->itens[i], strlen(d->itens[i])) & (cap - 1);
+            while (novo[j]) j = (j + 1) & (cap - 1);
+            novo[j] = i + 1;
+        }
+        free(d->slots);
+        d->slots = novo;
+        d->mascara = cap - 1;
+    }
+    size_t j = hash_matricula(s, strlen(s)) & d->mascara;
+    while (d->slots[j]) {
+        if (strcmp(d->itens[d->slots[j] - 1], s) == 0) return d->slots[j] - 1;
+        j = (j + 1) & d->mascara;
+    }
+    if (d->qtd == d->cap) {
+        int nova_cap = d->cap ? d->cap * 2 : 32;
+        char **novo = (char**) realloc(d->itens, nova_cap * sizeof(char*));
+        if (!novo) return -1;
+        d->itens = novo;
+        d->cap = nova_cap;
+    }
+    char *copia = (char*) malloc(strlen(s) + 1);
+    if (!copia) return -1;
+    strcpy(copia, s);
+    d->itens[d->qtd] = copia;
+    d->slots[j] = d->qtd + 1;
+    return d->qtd++;
+}
+
+static void liberar_dicionario(DicionarioArq *d) {
+    for (int i = 0; i < d->qtd; i++) free(d->itens[i]);
+    free(d->itens);
+    free(d->slots);
+}
+
+/* --- Arquivamento --- */
+
+typedef struct {
+    int alunos, blocos;
+    long bytes_arquivo;         // Tamanho final do arquivo
+    long bytes_memoria;         // Estimativa do que o ano ocupa hoje em Heap
+} ResumoArquivo;
+
+typedef struct {
+    Aluno *aluno;
+    Turma *turma;
+} AlunoParaArquivar;
+
+static int comparar_arquivar(const void *x, const void *y) {
+    return strcmp(((const AlunoParaArquivar*) x)->aluno->matricula,
+                  ((const AlunoParaArquivar*) y)->aluno->matricula);
+}
+
+// Codifica até ARQ_BLOCO_ALUNOS alunos já ordenados, coluna por coluna
+static void codificar_bloco_arquivo(BufferArq *b, const AlunoParaArquivar *v, int n, DicionarioArq *dic) {
+    // Matrículas: prefixo comum com a anterior + sufixo
+    const char *anterior = "";
+    for (int i = 0; i < n; i++) {
+        const char *m = v[i].aluno->matricula;
+        uint32_t comum = 0;
+        while (m[comum] && m[comum] == anterior[comum]) comum++;
+        buf_varint(b, comum);
+        buf_texto(b, m + comum);
+        anterior = m;
+    }
+    for (int i = 0; i < n; i++) buf_texto(b, v[i].aluno->nome);
+    for (int i = 0; i < n; i++) {
+        unsigned char serie = (unsigned char) v[i].aluno->serie;
+        buf_bytes(b, &serie, 1);
+    }
+    for (int i = 0; i < n; i++) buf_varint(b, (uint32_t) dicionario_id(dic, v[i].turma->codigo));
+
+    // Grade: quantidade, nome e professor (0 = sem professor) de cada disciplina
+    for (int i = 0; i < n; i++) {
+        unsigned char qtd = 0;
+        for (Disciplina *d = v[i].aluno->lista_disciplinas; d; d = d->proximo) qtd++;
+        buf_bytes(b, &qtd, 1);
+    }
+    for (int i = 0; i < n; i++)
+        for (Disciplina *d = v[i].aluno->lista_disciplinas; d; d = d->proximo)
+            buf_varint(b, (uint32_t) dicionario_id(dic, d->nome));
+    for (int i = 0; i < n; i++)
+        for (Disciplina *d = v[i].aluno->lista_disciplinas; d; d = d->proximo)
+            buf_varint(b, d->docente ? (uint32_t) dicionario_id(dic, d->docente->nome) + 1 : 0);
+
+    // Notas: varint(valor) ou 0 seguido do tamanho da corrida de zeros
+    uint32_t zeros = 0;
+    for (int i = 0; i < n; i++)
+        for (Disciplina *d = v[i].aluno->lista_disciplinas; d; d = d->proximo)
+            for (int u = 0; u < 4; u++) {
+                Nota provas[2] = {d->unidades[u].prova1, d->unidades[u].prova2};
+                for (int p = 0; p < 2; p++) {
+                    if (provas[p] == 0) { zeros++; continue; }
+                    if (zeros) { buf_varint(b, 0); buf_varint(b, zeros); zeros = 0; }
+                    buf_varint(b, provas[p]);
+                }
+            }
+    if (zeros) { buf_varint(b, 0); buf_varint(b, zeros); }
+
+    // Médias calculadas no arquivamento: a consulta não refaz contas
+    for (int i = 0; i < n; i++)
+        for (Disciplina *d = v[i].aluno->lista_disciplinas; d; d = d->proximo)
+            buf_varint(b, d->media_final);
+    for (int i = 0; i < n; i++) buf_varint(b, (uint32_t) calcular_media_aluno(v[i].aluno));
+    // Frequência + 1 (0 = sem chamada no ano)
+    for (int i = 0; i < n; i++)
+        buf_varint(b, (uint32_t) (frequencia_milesimos(frequencia_aluno(v[i].aluno)) + 1));
+    // Média de aprovação da regra da turma (as regras mudam de um ano para outro)
+    for (int i = 0; i < n; i++) buf_varint(b, plano_aluno(v[i].aluno)->aprovacao);
+}
+
+static void esquecer_arquivo_ano(const char *caminho); // Cache de arquivos abertos (abaixo)
+
+/* Congela todas as turmas da lista em 'caminho'. Retorna 1 se gravou. O
+   arquivo é montado em '<caminho>.tmp' e só substitui o anterior no fim. */
+int arquivar_ano_letivo(Turma *lista_turmas, int ano, const char *caminho, ResumoArquivo *res) {
+    RASTREAR("arquivar_ano_letivo");
+    memset(res, 0, sizeof(ResumoArquivo));
+    int total = 0;
+    for (Turma *t = lista_turmas; t; t = t->proximo_turma) total += t->qtd_atual;
+
+    AlunoParaArquivar *v = (AlunoParaArquivar*) malloc((total + 1) * sizeof(AlunoParaArquivar));
+    if (!v) return 0;
+    int n = 0;
+    for (Turma *t = lista_turmas; t; t = t->proximo_turma)
+        for (Aluno *a = t->lista_alunos; a && n < total; a = a->proximo) {
+            v[n].aluno = a;
+            v[n].turma = t;
+            n++;
+            res->bytes_memoria += sizeof(Aluno);
+            for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo)
+                res->bytes_memoria += sizeof(Disciplina);
+        }
+    qsort(v, n, sizeof(AlunoParaArquivar), comparar_arquivar);
+
+    char temporario[300];
+    snprintf(temporario, sizeof(temporario), "%s.tmp", caminho);
+    FILE *arq = fopen(temporario, "wb");
+    if (!arq) { free(v); return 0; }
+
+    int qtd_blocos = (n + ARQ_BLOCO_ALUNOS - 1) / ARQ_BLOCO_ALUNOS;
+    DicionarioArq dic = {0};
+    BufferArq bloco = {0}, indice = {0}, cabecalho = {0};
+    uint64_t pos = ARQ_CABECALHO;
+    int ok = 1;
+
+    // O cabeçalho definitivo só é conhecido no fim: reserva o espaço
+    unsigned char vazio[ARQ_CABECALHO] = {0};
+    ok = fwrite(vazio, 1, ARQ_CABECALHO, arq) == ARQ_CABECALHO;
+
+    for (int k = 0; k < qtd_blocos && ok; k++) {
+        int ini = k * ARQ_BLOCO_ALUNOS;
+        int qtd = (n - ini < ARQ_BLOCO_ALUNOS) ? n - ini : ARQ_BLOCO_ALUNOS;
+        bloco.tam = 0;
+        codificar_bloco_arquivo(&bloco, v + ini, qtd, &dic);
+        ok = fwrite(bloco.dados, 1, bloco.tam, arq) == bloco.tam;
+
+        buf_u64(&indice, pos);
+        buf_u32(&indice, (uint32_t) bloco.tam);
+        buf_varint(&indice, (uint32_t) qtd);
+        buf_texto(&indice, v[ini].aluno->matricula);
+        pos += bloco.tam;
+    }
+
+    uint64_t pos_dicionario = pos;
+    bloco.tam = 0;
+    for (int i = 0; i < dic.qtd; i++) buf_texto(&bloco, dic.itens[i]);
+    if (ok) ok = fwrite(bloco.dados, 1, bloco.tam, arq) == bloco.tam;
+    uint64_t pos_indice = pos_dicionario + bloco.tam;
+    if (ok && indice.tam) ok = fwrite(indice.dados, 1, indice.tam, arq) == indice.tam;
+
+    buf_bytes(&cabecalho, ARQ_MAGICO, 4);
+    buf_u32(&cabecalho, ((uint32_t) ARQ_VERSAO << 16) | (uint16_t) ano);
+    buf_u32(&cabecalho, (uint32_t) n);
+    buf_u32(&cabecalho, (uint32_t) qtd_blocos);
+    buf_u32(&cabecalho, (uint32_t) dic.qtd);
+    buf_u32(&cabecalho, (uint32_t) (pos_indice - pos_dicionario));
+    buf_u64(&cabecalho, pos_indice);
+    if (ok) ok = fseek(arq, 0, SEEK_SET) == 0 && fwrite(cabecalho.dados, 1, cabecalho.tam, arq) == cabecalho.tam;
+    if (fclose(arq) != 0) ok = 0;
+
+    res->alunos = n;
+    res->blocos = qtd_blocos;
+    res->bytes_arquivo = (long) (pos_indice + indice.tam);
+
+    free(bloco.dados);
+    free(indice.dados);
+    free(cabecalho.dados);
+    liberar_dicionario(&dic);
+    free(v);
+    if (ok) {
+        // Quem já consultou este ano guarda índice e blocos da versão anterior
+        esquecer_arquivo_ano(caminho);
+#ifdef _WIN32
+        remove(caminho); // rename não substitui um arquivo existente no Windows
+#endif
+        ok = rename(temporario, caminho) == 0;
+    }
+    if (!ok) remove(temporario); // Arquivo parcial não serve para consulta
+    return ok;
+}
+
+/* --- Consulta sob demanda --- */
+
+typedef struct {
+    char matricula[20];
+    char nome[100];
+    int serie;
+    const char *turma;              // Aponta para o dicionário do arquivo
+    int qtd_disciplinas;
+    const char *disciplina[MAX_DISCIPLINAS];
+    const char *docente[MAX_DISCIPLINAS];   // NULL = sem professor
+    Nota notas[MAX_DISCIPLINAS][8];         // [disciplina][unidade * 2 + prova - 1]
+    Nota media[MAX_DISCIPLINAS];
+    int media_geral;
+    int frequencia;                         // Milésimos (-1 = sem chamada)
+    Nota aprovacao;                         // Média mínima da regra vigente no ano
+} AlunoArquivado;
+
+typedef struct {
+    uint64_t pos;
+    uint32_t tamanho;
+    int qtd;
+    char primeira[20];              // Menor matrícula do bloco
+} EntradaIndiceArq;
+
+typedef struct {
+    AlunoArquivado *alunos;         // NULL = slot livre
+    int bloco, qtd;
+    unsigned long uso;              // Relógio do último acesso (LRU)
+} BlocoCarregado;
+
+typedef struct ArquivoAno {
+    char caminho[256];
+    FILE *arq;
+    int versao, ano, qtd_alunos, qtd_blocos;
+    char **dicionario;
+    int qtd_dicionario;
+    EntradaIndiceArq *indice;
+    BlocoCarregado cache[ARQ_CACHE_BLOCOS];
+    unsigned long relogio;
+    int leituras_disco;             // Blocos lidos do disco desde a abertura
+    struct ArquivoAno *proximo;
+} ArquivoAno;
+
+static ArquivoAno *arquivos_abertos = NULL;
+
+void fechar_arquivo_ano(ArquivoAno *a) {
+    if (!a) return;
+    if (a->arq) fclose(a->arq);
+    for (int i = 0; i < a->qtd_dicionario; i++) free(a->dicionario[i]);
+    free(a->dicionario);
+    free(a->indice);
+    for (int i = 0; i < ARQ_CACHE_BLOCOS; i++) free(a->cache[i].alunos);
+    free(a);
+}
+
+// Lê cabeçalho, dicionário e índice; os blocos ficam no disco
+ArquivoAno* abrir_arquivo_ano(const char *caminho) {
+    FILE *arq = fopen(caminho, "rb");
+    if (!arq) return NULL;
+    ArquivoAno *a = (ArquivoAno*) calloc(1, sizeof(ArquivoAno));
+    if (!a) { fclose(arq); return NULL; }
+    a->arq = arq;
+    snprintf(a->caminho, sizeof(a->caminho), "%s", caminho);
+
+    unsigned char cab[ARQ_CABECALHO];
+    if (fread(cab, 1, ARQ_CABECALHO, arq) != ARQ_CABECALHO || memcmp(cab, ARQ_MAGICO, 4) != 0) {
+        fechar_arquivo_ano(a);
+        return NULL;
+    }
+    LeitorArq l = {cab + 4, cab + ARQ_CABECALHO, 1};
+    uint32_t versao_ano = ler_u32(&l);
+    a->versao = (int) (versao_ano >> 16);
+    a->ano = (int) (versao_ano & 0xFFFF);
+    a->qtd_alunos = (int) ler_u32(&l);
+    a->qtd_blocos = (int) ler_u32(&l);
+    a->qtd_dicionario = 0;
+    int qtd_dicionario = (int) ler_u32(&l);
+    uint32_t tam_dicionario = ler_u32(&l);
+    uint64_t pos_indice = ler_u64(&l);
+    if (a->versao < ARQ_VERSAO_MINIMA || a->versao > ARQ_VERSAO) { fechar_arquivo_ano(a); return NULL; }
+
+    // Dicionário e índice ficam juntos no fim do arquivo: uma leitura só
+    if (fseek(arq, 0, SEEK_END) != 0) { fechar_arquivo_ano(a); return NULL; }
+    long fim = ftell(arq);
+    uint64_t pos_dicionario = pos_indice - tam_dicionario;
+    if (fim < 0 || pos_indice > (uint64_t) fim || tam_dicionario > pos_indice) {
+        fechar_arquivo_ano(a);
+        return NULL;
+    }
+    size_t tam_final = (size_t) ((uint64_t) fim - pos_dicionario);
+    unsigned char *final = (unsigned char*) malloc(tam_final ? tam_final : 1);
+    a->dicionario = (char**) calloc(qtd_dicionario + 1, sizeof(char*));
+    a->indice = (EntradaIndiceArq*) calloc(a->qtd_blocos + 1, sizeof(EntradaIndiceArq));
+    if (!final || !a->dicionario || !a->indice || fseek(arq, (long) pos_dicionario, SEEK_SET) != 0 ||
+        fread(final, 1, tam_final, arq) != tam_final) {
+        free(final);
+        fechar_arquivo_ano(a);
+        return NULL;
+    }
+
+    l.p = final;
+    l.fim = final + tam_final;
+    for (int i = 0; i < qtd_dicionario && l.ok; i++) {
+        char tmp[100];
+        ler_texto(&l, tmp, sizeof(tmp));
+        a->dicionario[i] = (char*) malloc(strlen(tmp) + 1);
+        if (!a->dicionario[i]) { l.ok = 0; break; }
+        strcpy(a->dicionario[i], tmp);
+        a->qtd_dicionario++;
+    }
+    for (int k = 0; k < a->qtd_blocos && l.ok; k++) {
+        a->indice[k].pos = ler_u64(&l);
+        a->indice[k].tamanho = ler_u32(&l);
+        a->indice[k].qtd = (int) ler_varint(&l);
+        ler_texto(&l, a->indice[k].primeira, sizeof(a->indice[k].primeira));
+        if (a->indice[k].qtd > ARQ_BLOCO_ALUNOS) l.ok = 0;
+    }
+    free(final);
+    if (!l.ok) { fechar_arquivo_ano(a); return NULL; }
+    return a;
+}
+
+static const char* dicionario_arquivo(const ArquivoAno *a, uint32_t id) {
+    return id < (uint32_t) a->qtd_dicionario ? a->dicionario[id] : "?";
+}
+
+static int decodificar_bloco_arquivo(const ArquivoAno *a, LeitorArq *l, AlunoArquivado *v, int n) {
+    char anterior[20] = "";
+    for (int i = 0; i < n; i++) {
+        uint32_t comum = ler_varint(l);
+        char sufixo[20];
+        ler_texto(l, sufixo, sizeof(sufixo));
+        size_t tam_sufixo = strlen(sufixo);
+        if (comum > strlen(anterior) || comum + tam_sufixo >= sizeof(anterior)) return 0;
+        memcpy(v[i].matricula, anterior, comum);
+        memcpy(v[i].matricula + comum, sufixo, tam_sufixo + 1);
+        strcpy(anterior, v[i].matricula);
+    }
+    for (int i = 0; i < n; i++) ler_texto(l, v[i].nome, sizeof(v[i].nome));
+    for (int i = 0; i < n; i++) {
+        unsigned char serie;
+        ler_bytes(l, &serie, 1);
+        v[i].serie = serie;
+    }
+    for (int i = 0; i < n; i++) v[i].turma = dicionario_arquivo(a, ler_varint(l));
+    for (int i = 0; i < n; i++) {
+        unsigned char qtd;
+        ler_bytes(l, &qtd, 1);
+        if (qtd > MAX_DISCIPLINAS) return 0;
+        v[i].qtd_disciplinas = qtd;
+    }
+    for (int i = 0; i < n; i++)
+        for (int d = 0; d < v[i].qtd_disciplinas; d++)
+            v[i].disciplina[d] = dicionario_arquivo(a, ler_varint(l));
+    for (int i = 0; i < n; i++)
+        for (int d = 0; d < v[i].qtd_disciplinas; d++) {
+            uint32_t id = ler_varint(l);
+            v[i].docente[d] = id ? dicionario_arquivo(a, id - 1) : NULL;
+        }
+    uint32_t zeros = 0;
+    for (int i = 0; i < n; i++)
+        for (int d = 0; d < v[i].qtd_disciplinas; d++)
+            for (int s = 0; s < 8; s++) {
+                if (zeros == 0) {
+                    uint32_t valor = ler_varint(l);
+                    if (valor == 0) zeros = ler_varint(l);
+                    else { v[i].notas[d][s] = (Nota) valor; continue; }
+                    if (zeros == 0) return 0;
+                }
+                v[i].notas[d][s] = 0;
+                zeros--;
+            }
+    for (int i = 0; i < n; i++)
+        for (int d = 0; d < v[i].qtd_disciplinas; d++) v[i].media[d] = (Nota) ler_varint(l);
+    for (int i = 0; i < n; i++) v[i].media_geral = (int) ler_varint(l);
+    // v1 não tinha frequência (sem chamada) e v1/v2 não tinham a média da regra
+    for (int i = 0; i < n; i++) v[i].frequencia = a->versao >= 2 ? (int) ler_varint(l) - 1 : -1;
+    for (int i = 0; i < n; i++) v[i].aprovacao = a->versao >= 3 ? (Nota) ler_varint(l) : MEDIA_APROVACAO;
+    return l->ok;
+}
+
+// Devolve o bloco decodificado, lendo do disco só se não estiver no cache
+static BlocoCarregado* carregar_bloco_arquivo(ArquivoAno *a, int k) {
+    BlocoCarregado *vitima = &a->cache[0];
+    for (int i = 0; i < ARQ_CACHE_BLOCOS; i++) {
+        BlocoCarregado *c = &a->cache[i];
+        if (c->alunos && c->bloco == k) {
+            c->uso = ++a->relogio;
+            return c;
+        }
+        if (!c->alunos) { if (vitima->alunos) vitima = c; }
+        else if (vitima->alunos && c->uso < vitima->uso) vitima = c;
+    }
+
+    EntradaIndiceArq *e = &a->indice[k];
+    unsigned char *bruto = (unsigned char*) malloc(e->tamanho ? e->tamanho : 1);
+    if (!bruto) return NULL;
+    if (fseek(a->arq, (long) e->pos, SEEK_SET) != 0 || fread(bruto, 1, e->tamanho, a->arq) != e->tamanho) {
+        free(bruto);
+        return NULL;
+    }
+    if (!vitima->alunos) vitima->alunos = (AlunoArquivado*) malloc(ARQ_BLOCO_ALUNOS * sizeof(AlunoArquivado));
+    if (!vitima->alunos) { free(bruto); return NULL; }
+    memset(vitima->alunos, 0, ARQ_BLOCO_ALUNOS * sizeof(AlunoArquivado));
+
+    LeitorArq l = {bruto, bruto + e->tamanho, 1};
+    int ok = decodificar_bloco_arquivo(a, &l, vitima->alunos, e->qtd);
+    free(bruto);
+    a->leituras_disco++;
+    if (!ok) {
+        free(vitima->alunos);
+        vitima->alunos = NULL;
+        return NULL;
+    }
+    vitima->bloco = k;
+    vitima->qtd = e->qtd;
+    vitima->uso = ++a->relogio;
+    return vitima;
+}
+
+/* Registro arquivado da matrícula (NULL se não consta do ano). O ponteiro
+   vale até a próxima consulta ao mesmo arquivo (o bloco pode sair do cache). */
+const AlunoArquivado* consultar_arquivo(ArquivoAno *a, const char *matricula) {
+    RASTREAR("consultar_arquivo");
+    if (!a || a->qtd_blocos == 0) return NULL;
+    // Último bloco cuja primeira matrícula é <= a procurada
+    int ini = 0, fim = a->qtd_blocos;
+    while (fim - ini > 1) {
+        int meio = (ini + fim) / 2;
+        if (strcmp(a->indice[meio].primeira, matricula) <= 0) ini = meio;
+        else fim = meio;
+    }
+    BlocoCarregado *b = carregar_bloco_arquivo(a, ini);
+    if (!b) return NULL;
+    int lo = 0, hi = b->qtd - 1;
+    while (lo <= hi) {
+        int meio = (lo + hi) / 2;
+        int c = strcmp(b->alunos[meio].matricula, matricula);
+        if (c == 0) return &b->alunos[meio];
+        if (c < 0) lo = meio + 1; else hi = meio - 1;
+    }
+    return NULL;
+}
+
+// Fecha e tira do cache o arquivo aberto em 'caminho' (se houver)
+static void esquecer_arquivo_ano(const char *caminho) {
+    for (ArquivoAno **p = &arquivos_abertos; *p; p = &(*p)->proximo)
+        if (strcmp((*p)->caminho, caminho) == 0) {
+            ArquivoAno *a = *p;
+            *p = a->proximo;
+            fechar_arquivo_ano(a);
+            return;
+        }
+}
+
+// Arquivo do ano do campus com o nome padrão, aberto uma vez e mantido para consultas
+ArquivoAno* arquivo_do_ano(const char *campus, int ano) {
+    char caminho[256];
+    caminho_arquivo_ano(caminho, sizeof(caminho), campus, ano);
+    for (ArquivoAno *a = arquivos_abertos; a; a = a->proximo)
+        if (strcmp(a->caminho, caminho) == 0) return a;
+    ArquivoAno *a = abrir_arquivo_ano(caminho);
+    if (!a) return NULL;
+    a->proximo = arquivos_abertos;
+    arquivos_abertos = a;
+    return a;
+}
+
+void fechar_arquivos_abertos(void) {
+    while (arquivos_abertos) {
+        ArquivoAno *a = arquivos_abertos;
+        arquivos_abertos = a->proximo;
+        fechar_arquivo_ano(a);
+    }
+}
+
+// Boletim de um ano encerrado, no mesmo formato do boletim do ano corrente
+void exibir_boletim_arquivado(const AlunoArquivado *r, int ano) {
+    printf("\n========= BOLETIM KOLPING %d: %s (%s) =========\n", ano, r->nome, r->matricula);
+    printf("Turma: %s | Serie: %d\n", r->turma, r->serie);
+    for (int d = 0; d < r->qtd_disciplinas; d++)
+        printf("- %-15s | Media Final: %.2f | Prof: %s\n",
+               r->disciplina[d], nota_para_float(r->media[d]), r->docente[d] ? r->docente[d] : "N/A");
+    int aprovado = r->media_geral >= r->aprovacao &&
+                   (r->frequencia < 0 || r->frequencia >= FREQUENCIA_MINIMA);
+    printf("Media Geral: %.2f", nota_para_float((Nota) r->media_geral));
+    if (r->frequencia >= 0) printf(" | Frequencia: %.1f%%", r->frequencia / 10.0);
+    printf(" | Situacao: %s\n", aprovado ? "APROVADO" : "REPROVADO");
+    printf("======================================================\n");
+}
+
+/* ==========================================================================
+   EXPORTAÇÕES EM SEGUNDO PLANO (FILA DE TAREFAS + SNAPSHOT)
+   ========================================================================== */
+
+/* Relatórios de fechamento e exportações CSV não rodam mais no portal: a
+   thread principal tira um snapshot das turmas envolvidas e enfileira a
+   tarefa; uma thread de fundo renderiza a partir do snapshot e grava em
+   arquivo com buffer grande. O snapshot é uma cópia plana (um vetor de
+   Turma, um de Aluno e um de Disciplina, reencadeados entre si), então
+   quem continua lançando notas nunca compartilha memória com a tarefa, e o
+   relatório sai pelas mesmas funções de renderização do portal. */
+
+#define EXPORT_BUFFER   (1 << 20)   // Buffer do arquivo e limiar de descarga
+
+typedef enum { TAREFA_RELATORIO, TAREFA_CSV } TipoTarefa;
+typedef enum { TAREFA_PENDENTE, TAREFA_EXECUTANDO, TAREFA_CONCLUIDA, TAREFA_FALHOU } EstadoTarefa;
+
+static const char *NOMES_ESTADO_TAREFA[] = {"pendente", "executando", "concluida", "falhou"};
+
+typedef struct {
+    Turma *turmas;              // Cópias encadeadas por proximo_turma
+    Aluno *alunos;
+    Disciplina *disciplinas;
+    char (*docentes)[100];      // Nome do professor de cada disciplina copiada
+    PlanoAvaliacao *planos;     // Regra resolvida de cada turma copiada
+    int qtd_turmas, qtd_alunos;
+} SnapshotExportacao;
+
+typedef struct {
+    int id;
+    TipoTarefa tipo;
+    char caminho[256];
+    char descricao[64];
+    EstadoTarefa estado;        // Protegido pela trava do exportador
+    long bytes;
+    double segundos;
+    SnapshotExportacao snap;
+} TarefaExportacao;
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t trava;
+    pthread_cond_t sinal;
+    TarefaExportacao **tarefas; // Todas as tarefas da sessão, em ordem de envio
+    int qtd, cap;
+    int proxima;                // Primeira ainda não iniciada
+    int iniciado, encerrando;
+} Exportador;
+
+static Exportador exportador = {.trava = PTHREAD_MUTEX_INITIALIZER, .sinal = PTHREAD_COND_INITIALIZER};
+
+/* Copia 'unica' (ou a lista inteira, se unica == NULL). */
+static int tirar_snapshot(SnapshotExportacao *s, Turma *lista, Turma *unica) {
+    RASTREAR("tirar_snapshot");
+    memset(s, 0, sizeof(SnapshotExportacao));
+    int qtd_disciplinas = 0;
+    for (Turma *t = unica ? unica : lista; t; t = unica ? NULL : t->proximo_turma) {
+        s->qtd_turmas++;
+        for (Aluno *a = t->lista_alunos; a; a = a->proximo) {
+            s->qtd_alunos++;
+            for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo) qtd_disciplinas++;
+        }
+    }
+    s->turmas = (Turma*) calloc(s->qtd_turmas + 1, sizeof(Turma));
+    s->alunos = (Aluno*) calloc(s->qtd_alunos + 1, sizeof(Aluno));
+    s->disciplinas = (Disciplina*) calloc(qtd_disciplinas + 1, sizeof(Disciplina));
+    s->docentes = (char (*)[100]) calloc(qtd_disciplinas + 1, sizeof(*s->docentes));
+    s->planos = (PlanoAvaliacao*) calloc(s->qtd_turmas + 1, sizeof(PlanoAvaliacao));
+    if (!s->turmas || !s->alunos || !s->disciplinas || !s->docentes || !s->planos) return 0;
+
+    int it = 0, ia = 0, id = 0;
+    for (Turma *t = unica ? unica : lista; t; t = unica ? NULL : t->proximo_turma) {
+        Turma *ct = &s->turmas[it];
+        memcpy(ct, t, sizeof(Turma));
+        memset(&ct->cache_relatorio, 0, sizeof(CacheTexto));
+        memset(ct->roster, 0, sizeof(ct->roster));
+        ct->historico = NULL;
+        s->planos[it] = *plano_turma(t);
+        ct->plano = &s->planos[it];
+        ct->versao = 1;
+        ct->lista_alunos = NULL;
+        ct->proximo_turma = (it + 1 < s->qtd_turmas) ? &s->turmas[it + 1] : NULL;
+        Aluno **fim_alunos = &ct->lista_alunos;
+        for (Aluno *a = t->lista_alunos; a; a = a->proximo) {
+            Aluno *ca = &s->alunos[ia++];
+            memcpy(ca, a, sizeof(Aluno));
+            memset(&ca->cache_boletim, 0, sizeof(CacheTexto));
+            memset(&ca->cache_relatorio, 0, sizeof(CacheTexto));
+            ca->saltos = NULL;
+            ca->turma = ct;
+            ca->versao = 1;
+            ca->proximo = NULL;
+            ca->lista_disciplinas = NULL;
+            *fim_alunos = ca;
+            fim_alunos = &ca->proximo;
+            Disciplina **fim_disc = &ca->lista_disciplinas;
+            for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo) {
+                Disciplina *cd = &s->disciplinas[id];
+                memcpy(cd, d, sizeof(Disciplina));
+                if (d->docente) snprintf(s->docentes[id], sizeof(s->docentes[id]), "%s", d->docente->nome);
+                cd->docente = NULL;
+                cd->proximo = NULL;
+                *fim_disc = cd;
+                fim_disc = &cd->proximo;
+                id++;
+            }
+        }
+        it++;
+    }
+    return 1;
+}
+
+static void liberar_snapshot(SnapshotExportacao *s) {
+    for (int i = 0; i < s->qtd_turmas; i++) texto_liberar(&s->turmas[i].cache_relatorio.texto);
+    for (int i = 0; i < s->qtd_alunos; i++) texto_liberar(&s->alunos[i].cache_relatorio.texto);
+    free(s->turmas);
+    free(s->alunos);
+    free(s->disciplinas);
+    free(s->docentes);
+    free(s->planos);
+    memset(s, 0, sizeof(SnapshotExportacao));
+}
+
+// Grava o conteúdo acumulado e esvazia o texto; retorna 0 em erro de escrita
+static int descarregar_texto(FILE *arq, Texto *tx, long *bytes) {
+    if (tx->tamanho == 0) return 1;
+    int ok = fwrite(tx->dados, 1, tx->tamanho, arq) == tx->tamanho;
+    *bytes += (long) tx->tamanho;
+    texto_limpar(tx);
+    return ok;
+}
+
+static int executar_tarefa(TarefaExportacao *tf) {
+    RASTREAR("executar_tarefa");
+    FILE *arq = fopen(tf->caminho, "w");
+    if (!arq) return 0;
+    setvbuf(arq, NULL, _IOFBF, EXPORT_BUFFER);
+    SnapshotExportacao *s = &tf->snap;
+    Texto tx = {NULL, 0, 0};
+    int ok = 1;
+
+    if (tf->tipo == TAREFA_RELATORIO) {
+        for (int i = 0; i < s->qtd_turmas && ok; i++) {
+            renderizar_relatorio_turma(&s->turmas[i]);
+            Texto *rel = &s->turmas[i].cache_relatorio.texto;
+            ok = fwrite(rel->dados, 1, rel->tamanho, arq) == rel->tamanho;
+            tf->bytes += (long) rel->tamanho;
+        }
+    } else {
+        texto_printf(&tx, "matricula;nome;turma;serie;disciplina;professor;"
+                          "u1p1;u1p2;u2p1;u2p2;u3p1;u3p2;u4p1;u4p2;media_final\n");
+        for (int i = 0; i < s->qtd_alunos && ok; i++) {
+            Aluno *a = &s->alunos[i];
+            for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo) {
+                texto_printf(&tx, "%s;%s;%s;%d;%s;%s", a->matricula, a->nome, a->turma->codigo,
+                             a->serie, d->nome, s->docentes[d - s->disciplinas]);
+                for (int u = 0; u < 4; u++)
+                    texto_printf(&tx, ";%.2f;%.2f", nota_para_float(d->unidades[u].prova1),
+                                 nota_para_float(d->unidades[u].prova2));
+                texto_printf(&tx, ";%.2f\n", nota_para_float(d->media_final));
+            }
+            if (tx.tamanho >= EXPORT_BUFFER) ok = descarregar_texto(arq, &tx, &tf->bytes);
+        }
+        if (ok) ok = descarregar_texto(arq, &tx, &tf->bytes);
+    }
+    texto_liberar(&tx);
+    if (fclose(arq) != 0) ok = 0;
+    return ok;
+}
+
+static void* thread_exportador(void *arg) {
+    (void) arg;
+    rastreio_nomear_thread("exportacao");
+    pthread_mutex_lock(&exportador.trava);
+    for (;;) {
+        while (exportador.proxima == exportador.qtd && !exportador.encerrando)
+            pthread_cond_wait(&exportador.sinal, &exportador.trava);
+        if (exportador.proxima == exportador.qtd) break; // Encerrando e sem pendências
+        TarefaExportacao *tf = exportador.tarefas[exportador.proxima++];
+        tf->estado = TAREFA_EXECUTANDO;
+        pthread_mutex_unlock(&exportador.trava);
+
+        double inicio = relogio_segundos();
+        int ok = executar_tarefa(tf);
+        double duracao = relogio_segundos() - inicio;
+        liberar_snapshot(&tf->snap);
+
+        pthread_mutex_lock(&exportador.trava);
+        tf->segundos = duracao;
+        tf->estado = ok ? TAREFA_CONCLUIDA : TAREFA_FALHOU;
+    }
+    pthread_mutex_unlock(&exportador.trava);
+    return NULL;
+}
+
+// Tira o snapshot na thread chamadora e enfileira; retorna o id (0 = falhou)
+static int agendar_tarefa(TipoTarefa tipo, Turma *lista, Turma *unica, const char *caminho,
+                          const char *descricao) {
+    TarefaExportacao *tf = (TarefaExportacao*) calloc(1, sizeof(TarefaExportacao));
+    if (!tf) return 0;
+    if (!tirar_snapshot(&tf->snap, lista, unica)) {
+        liberar_snapshot(&tf->snap);
+        free(tf);
+        return 0;
+    }
+    tf->tipo = tipo;
+    tf->estado = TAREFA_PENDENTE;
+    snprintf(tf->caminho, sizeof(tf->caminho), "%s", caminho);
+    snprintf(tf->descricao, sizeof(tf->descricao), "%s", descricao);
+
+    pthread_mutex_lock(&exportador.trava);
+    int id = 0;
+    if (!exportador.iniciado && pthread_create(&exportador.thread, NULL, thread_exportador, NULL) == 0)
+        exportador.iniciado = 1;
+    if (exportador.iniciado && !exportador.encerrando) {
+        if (exportador.qtd == exportador.cap) {
+            int nova_cap = exportador.cap ? exportador.cap * 2 : 16;
+            TarefaExportacao **novo = (TarefaExportacao**) realloc(exportador.tarefas,
+                                                                   nova_cap * sizeof(TarefaExportacao*));
+            if (novo) {
+                exportador.tarefas = novo;
+                exportador.cap = nova_cap;
+            }
+        }
+        if (exportador.qtd < exportador.cap) {
+            tf->id = id = exportador.qtd + 1;
+            exportador.tarefas[exportador.qtd++] = tf;
+            pthread_cond_signal(&exportador.sinal);
+        }
+    }
+    pthread_mutex_unlock(&exportador.trava);
+    if (!id) {
+        liberar_snapshot(&tf->snap);
+        free(tf);
+    }
+    return id;
+}
+
+// Relatório de fechamento de uma turma, gravado em arquivo em segundo plano
+int agendar_relatorio(Turma *t, const char *caminho) {
+    if (!t) return 0;
+    char descricao[64];
+    snprintf(descricao, sizeof(descricao), "Relatorio %s", t->codigo);
+    return agendar_tarefa(TAREFA_RELATORIO, NULL, t, caminho, descricao);
+}
+
+// Todas as notas de todas as turmas da lista, uma linha por disciplina (CSV ';')
+int agendar_exportacao_csv(Turma *lista, const char *caminho) {
+    return agendar_tarefa(TAREFA_CSV, lista, NULL, caminho, "Exportacao CSV");
+}
+
+void exibir_tarefas_exportacao(void) {
+    pthread_mutex_lock(&exportador.trava);
+    if (exportador.qtd == 0) {
+        printf("\n[ Nenhuma exportacao nesta sessao ]\n");
+    } else {
+        printf("\n--- EXPORTACOES EM SEGUNDO PLANO ---\n");
+        for (int i = 0; i < exportador.qtd; i++) {
+            TarefaExportacao *tf = exportador.tarefas[i];
+            printf("#%-3d %-20s | %-10s | %s", tf->id, tf->descricao,
+                   NOMES_ESTADO_TAREFA[tf->estado], tf->caminho);
+            if (tf->estado == TAREFA_CONCLUIDA)
+                printf(" | %ld bytes em %.3fs", tf->bytes, tf->segundos);
+            printf("\n");
+        }
+    }
+    pthread_mutex_unlock(&exportador.trava);
+}
+
+/* Conclui as tarefas pendentes, encerra a thread e libera o histórico. */
+void encerrar_exportacoes(void) {
+    pthread_mutex_lock(&exportador.trava);
+    int iniciado = exportador.iniciado;
+    exportador.encerrando = 1;
+    pthread_cond_signal(&exportador.sinal);
+    pthread_mutex_unlock(&exportador.trava);
+    if (iniciado) pthread_join(exportador.thread, NULL);
+    for (int i = 0; i < exportador.qtd; i++) free(exportador.tarefas[i]);
+    free(exportador.tarefas);
+    exportador.tarefas = NULL;
+    exportador.qtd = exportador.cap = exportador.proxima = 0;
+    exportador.iniciado = 0;
+}
+
+/* ==========================================================================
+   RÉPLICA DE LEITURA EM MEMÓRIA COMPARTILHADA (DESLOCAMENTOS + SEQLOCK)
+   ========================================================================== */
+
+/* O processo principal (--publicar) copia o estado do campus para uma
+   região POSIX (shm_open) sem ponteiros: tudo é vetor de registros de
+   tamanho fixo ligados por índice, então a imagem vale em qualquer endereço
+   de mapeamento. Processos de consulta (--leitor) mapeiam a região só para
+   leitura e atendem boletins e relatórios a partir dela.
+
+   Publicação em duas vagas (troca de época) com seqlock por vaga:
+     1. o escritor pega a vaga inativa e torna a sequência dela ímpar;
+     2. grava a imagem (crescendo a região, se preciso);
+     3. torna a sequência par e só então aponta 'ativa' para a vaga.
+   O leitor lê 'ativa' e a sequência (par), trabalha sobre a vaga e confere
+   se a sequência não mudou; se mudou (o escritor reciclou a vaga durante a
+   leitura), descarta o resultado e tenta de novo. O escritor nunca espera
+   por leitores, e o leitor nunca usa um resultado rasgado. Como a vaga pode
+   estar no meio de uma escrita, todo índice lido é validado antes de ser
+   seguido e todo texto é lido com limite de tamanho. */
+
+#define REPLICA_NOME_PADRAO  "/kolping_replica"
+#define REPLICA_MAGICO       "KREPLICA"
+#define REPLICA_VERSAO       1
+#define REPLICA_TENTATIVAS   1000     // Leituras rasgadas seguidas antes de desistir
+
+typedef struct {
+    char codigo[10];
+    int32_t serie, limite_vagas, qtd_atual;
+    uint32_t primeiro_aluno, qtd_alunos;    // Faixa no vetor de alunos (ordem do diário)
+    Nota aprovacao;                         // Média mínima da regra da turma
+} TurmaReplica;
+
+typedef struct {
+    char matricula[20];
+    char nome[100];
+    int32_t serie;
+    uint32_t turma;                         // Índice no vetor de turmas
+    uint32_t primeira_disciplina, qtd_disciplinas;
+    int32_t media_geral;                    // Centésimos
+    int32_t frequencia;                     // Milésimos (-1 = sem chamada)
+    int32_t aprovado;
+} AlunoReplica;
+
+typedef struct {
+    char nome[50];
+    char docente[100];                      // "" = sem professor
+    Nota media_unidade[4];
+    Nota recuperacao, media_final;
+    int32_t aulas, presencas;
+} DisciplinaReplica;
+
+// Início de cada vaga; deslocamentos relativos ao início da vaga
+typedef struct {
+    uint32_t qtd_turmas, qtd_alunos, qtd_disciplinas;
+    uint64_t off_turmas, off_alunos, off_disciplinas;
+    uint64_t off_indice;                    // Índices dos alunos em ordem de matrícula
+    int64_t publicado_em;
+    char campus[50];
+} ImagemReplica;
+
+typedef struct {
+    _Atomic uint64_t sequencia;             // Ímpar = vaga em escrita; 0 = nunca escrita
+    _Atomic uint64_t deslocamento;          // Posição da vaga na região
+    _Atomic uint64_t capacidade;
+} VagaReplica;
+
+typedef struct {
+    char magico[8];
+    uint32_t versao;
+    _Atomic uint32_t ativa;                 // Vaga da publicação mais recente
+    _Atomic uint64_t geracao;               // Publicações feitas
+    _Atomic uint64_t tamanho;               // Tamanho atual da região
+    VagaReplica vagas[2];
+} CabecalhoReplica;
+
+typedef struct {
+    int fd;
+    unsigned char *base;
+    size_t tamanho;
+    char nome[64];
+    unsigned long marca;                    // Assinatura das versões na última publicação
+    int publicou;
+} PublicadorReplica;
+
+typedef struct {
+    int fd;
+    const unsigned char *base;
+    size_t tamanho;
+} LeitorReplica;
+
+static uint64_t replica_alinhar(uint64_t n, uint64_t a) {
+    return (n + a - 1) / a * a;
+}
+
+// Assinatura barata do estado: muda a cada matrícula, remoção ou alteração de aluno
+static unsigned long replica_marca(Turma *lista) {
+    unsigned long marca = 1;
+    for (Turma *t = lista; t; t = t->proximo_turma) marca = marca * 31 + t->versao;
+    return marca;
+}
+
+#ifndef _WIN32
+
+/* --- Escritor --- */
+
+int iniciar_publicacao(PublicadorReplica *p, const char *nome) {
+    memset(p, 0, sizeof(PublicadorReplica));
+    snprintf(p->nome, sizeof(p->nome), "%s", nome ? nome : REPLICA_NOME_PADRAO);
+    // Nomes, notas e frequência: só o próprio usuário (os leitores rodam como ele)
+    p->fd = shm_open(p->nome, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (p->fd < 0) return 0;
+    if (fchmod(p->fd, 0600) != 0) { close(p->fd); return 0; } // Objeto antigo pode ter outro modo
+    p->tamanho = (size_t) replica_alinhar(sizeof(CabecalhoReplica), 4096);
+    if (ftruncate(p->fd, (off_t) p->tamanho) != 0) { close(p->fd); shm_unlink(p->nome); return 0; }
+    p->base = mmap(NULL, p->tamanho, PROT_READ | PROT_WRITE, MAP_SHARED, p->fd, 0);
+    if (p->base == MAP_FAILED) { close(p->fd); shm_unlink(p->nome); p->base = NULL; return 0; }
+    CabecalhoReplica *c = (CabecalhoReplica*) p->base;
+    memcpy(c->magico, REPLICA_MAGICO, 8);
+    c->versao = REPLICA_VERSAO;
+    atomic_store(&c->tamanho, p->tamanho);
+    return 1;
+}
+
+/* Garante 'capacidade' bytes para a vaga (em escrita): se não cabe, a vaga
+   passa para o fim da região, que cresce. O espaço antigo fica ocioso. */
+static int replica_reservar(PublicadorReplica *p, int vaga, uint64_t capacidade) {
+    CabecalhoReplica *c = (CabecalhoReplica*) p->base;
+    if (atomic_load_explicit(&c->vagas[vaga].capacidade, memory_order_relaxed) >= capacidade) return 1;
+    uint64_t deslocamento = p->tamanho;
+    size_t novo = (size_t) replica_alinhar(deslocamento + capacidade, 4096);
+    if (ftruncate(p->fd, (off_t) novo) != 0) return 0;
+    unsigned char *base = mmap(NULL, novo, PROT_READ | PROT_WRITE, MAP_SHARED, p->fd, 0);
+    if (base == MAP_FAILED) return 0;
+    munmap(p->base, p->tamanho);
+    p->base = base;
+    p->tamanho = novo;
+    c = (CabecalhoReplica*) p->base;
+    atomic_store_explicit(&c->vagas[vaga].deslocamento, deslocamento, memory_order_relaxed);
+    atomic_store_explicit(&c->vagas[vaga].capacidade, novo - deslocamento, memory_order_relaxed);
+    atomic_store_explicit(&c->tamanho, novo, memory_order_release);
+    return 1;
+}
+
+typedef struct {
+    const char *matricula;
+    uint32_t indice;
+} OrdemReplica;
+
+static int comparar_ordem_replica(const void *x, const void *y) {
+    return strcmp(((const OrdemReplica*) x)->matricula, ((const OrdemReplica*) y)->matricula);
+}
+
+/* Publica a lista de turmas se algo mudou desde a última publicação (ou se
+   'forcar'). Retorna 1 se publicou, 0 se nada mudou, -1 em erro. */
+int publicar_replica(PublicadorReplica *p, Turma *lista, const char *campus, int forcar) {
+    RASTREAR("publicar_replica");
+    if (!p->base) return -1;
+    unsigned long marca = replica_marca(lista);
+    if (p->publicou && !forcar && marca == p->marca) return 0;
+
+    uint32_t qtd_turmas = 0, qtd_alunos = 0, qtd_disciplinas = 0;
+    for (Turma *t = lista; t; t = t->proximo_turma) {
+        qtd_turmas++;
+        for (Aluno *a = t->lista_alunos; a; a = a->proximo) {
+            qtd_alunos++;
+            for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo) qtd_disciplinas++;
+        }
+    }
+    OrdemReplica *ordem = (OrdemReplica*) malloc(sizeof(OrdemReplica) * (qtd_alunos + 1));
+    if (!ordem) return -1;
+
+    uint64_t off_turmas = replica_alinhar(sizeof(ImagemReplica), 8);
+    uint64_t off_alunos = replica_alinhar(off_turmas + (uint64_t) qtd_turmas * sizeof(TurmaReplica), 8);
+    uint64_t off_disciplinas = replica_alinhar(off_alunos + (uint64_t) qtd_alunos * sizeof(AlunoReplica), 8);
+    uint64_t off_indice = replica_alinhar(off_disciplinas + (uint64_t) qtd_disciplinas * sizeof(DisciplinaReplica), 8);
+    uint64_t necessario = off_indice + (uint64_t) qtd_alunos * sizeof(uint32_t);
+
+    CabecalhoReplica *c = (CabecalhoReplica*) p->base;
+    int vaga = (int) (atomic_load_explicit(&c->ativa, memory_order_relaxed) ^ (p->publicou ? 1 : 0));
+    uint64_t seq = atomic_load_explicit(&c->vagas[vaga].sequencia, memory_order_relaxed);
+    atomic_store_explicit(&c->vagas[vaga].sequencia, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    if (!replica_reservar(p, vaga, necessario + necessario / 2)) {
+        free(ordem);
+        c = (CabecalhoReplica*) p->base;
+        atomic_store_explicit(&c->vagas[vaga].sequencia, seq + 2, memory_order_release);
+        return -1;
+    }
+    c = (CabecalhoReplica*) p->base;
+    unsigned char *v = p->base + atomic_load_explicit(&c->vagas[vaga].deslocamento, memory_order_relaxed);
+    ImagemReplica *im = (ImagemReplica*) v;
+    TurmaReplica *turmas = (TurmaReplica*) (v + off_turmas);
+    AlunoReplica *alunos = (AlunoReplica*) (v + off_alunos);
+    DisciplinaReplica *discs = (DisciplinaReplica*) (v + off_disciplinas);
+    uint32_t *indice = (uint32_t*) (v + off_indice);
+
+    uint32_t it = 0, ia = 0, id = 0;
+    for (Turma *t = lista; t; t = t->proximo_turma, it++) {
+        const PlanoAvaliacao *plano = plano_turma(t);
+        TurmaReplica *rt = &turmas[it];
+        memset(rt, 0, sizeof(TurmaReplica));
+        snprintf(rt->codigo, sizeof(rt->codigo), "%s", t->codigo);
+        rt->serie = t->serie;
+        rt->limite_vagas = t->limite_vagas;
+        rt->qtd_atual = t->qtd_atual;
+        rt->primeiro_aluno = ia;
+        rt->aprovacao = plano->aprovacao;
+        for (Aluno *a = t->lista_alunos; a; a = a->proximo) {
+            AlunoReplica *ra = &alunos[ia];
+            memset(ra, 0, sizeof(AlunoReplica));
+            snprintf(ra->matricula, sizeof(ra->matricula), "%s", a->matricula);
+            snprintf(ra->nome, sizeof(ra->nome), "%s", a->nome);
+            ra->serie = a->serie;
+            ra->turma = it;
+            ra->primeira_disciplina = id;
+            Frequencia f = frequencia_aluno(a);
+            ra->media_geral = calcular_media_aluno(a);
+            ra->frequencia = frequencia_milesimos(f);
+            ra->aprovado = situacao_final(plano, ra->media_geral, f);
+            for (Disciplina *d = a->lista_disciplinas; d; d = d->proximo) {
+                DisciplinaReplica *rd = &discs[id++];
+                memset(rd, 0, sizeof(DisciplinaReplica));
+                snprintf(rd->nome, sizeof(rd->nome), "%s", d->nome);
+                if (d->docente) snprintf(rd->docente, sizeof(rd->docente), "%s", d->docente->nome);
+                for (int u = 0; u < 4; u++) rd->media_unidade[u] = (Nota) media_unidade(plano, &d->unidades[u]);
+                rd->recuperacao = d->recuperacao;
+                rd->media_final = d->media_final;
+                Frequencia fd = frequencia_disciplina(d);
+                rd->aulas = fd.aulas;
+                rd->presencas = fd.presencas;
+                ra->qtd_disciplinas++;
+            }
+            ordem[ia].matricula = a->matricula;
+            ordem[ia].indice = ia;
+            ia++;
+        }
+        rt->qtd_alunos = ia - rt->primeiro_aluno;
+    }
+    qsort(ordem, qtd_alunos, sizeof(OrdemReplica), comparar_ordem_replica);
+    for (uint32_t i = 0; i < qtd_alunos; i++) indice[i] = ordem[i].indice;
+    free(ordem);
+
+    memset(im, 0, sizeof(ImagemReplica));
+    im->qtd_turmas = qtd_turmas;
+    im->qtd_alunos = qtd_alunos;
+    im->qtd_disciplinas = qtd_disciplinas;
+    im->off_turmas = off_turmas;
+    im->off_alunos = off_alunos;
+    im->off_disciplinas = off_disciplinas;
+    im->off_indice = off_indice;
+    im->publicado_em = (int64_t) time(NULL);
+    snprintf(im->campus, sizeof(im->campus), "%s", campus ? campus : "");
+
+    atomic_store_explicit(&c->vagas[vaga].sequencia, seq + 2, memory_order_release);
+    atomic_store_explicit(&c->ativa, (uint32_t) vaga, memory_order_release);
+    atomic_fetch_add_explicit(&c->geracao, 1, memory_order_release);
+    p->marca = marca;
+    p->publicou = 1;
+    return 1;
+}
+
+void encerrar_publicacao(PublicadorReplica *p) {
+    if (!p->base) return;
+    munmap(p->base, p->tamanho);
+    close(p->fd);
+    shm_unlink(p->nome);
+    memset(p, 0, sizeof(PublicadorReplica));
+}
+
+/* --- Leitor --- */
+
+int abrir_replica(LeitorReplica *l, const char *nome) {
+    memset(l, 0, sizeof(LeitorReplica));
+    l->fd = shm_open(nome ? nome : REPLICA_NOME_PADRAO, O_RDONLY, 0);
+    if (l->fd < 0) return 0;
+    struct stat st;
+    if (fstat(l->fd, &st) != 0 || (size_t) st.st_size < sizeof(CabecalhoReplica)) { close(l->fd); return 0; }
+    l->tamanho = (size_t) st.st_size;
+    void *base = mmap(NULL, l->tamanho, PROT_READ, MAP_SHARED, l->fd, 0);
+    if (base == MAP_FAILED) { close(l->fd); return 0; }
+    l->base = (const unsigned char*) base;
+    const CabecalhoReplica *c = (const CabecalhoReplica*) l->base;
+    if (memcmp(c->magico, REPLICA_MAGICO, 8) != 0 || c->versao != REPLICA_VERSAO) {
+        munmap(base, l->tamanho);
+        close(l->fd);
+        memset(l, 0, sizeof(LeitorReplica));
+        return 0;
+    }
+    return 1;
+}
+
+void fechar_replica(LeitorReplica *l) {
+    if (!l->base) return;
+    munmap((void*) l->base, l->tamanho);
+    close(l->fd);
+    memset(l, 0, sizeof(LeitorReplica));
+}
+
+// Remapeia se a região cresceu além do trecho mapeado
+static int replica_cobrir(LeitorReplica *l, uint64_t fim) {
+    if (fim <= l->tamanho) return 1;
+    struct stat st;
+    if (fstat(l->fd, &st) != 0 || (uint64_t) st.st_size < fim) return 0;
+    void *base = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, l->fd, 0);
+    if (base == MAP_FAILED) return 0;
+    munmap((void*) l->base, l->tamanho);
+    l->base = (const unsigned char*) base;
+    l->tamanho = (size_t) st.st_size;
+    return 1;
+}
+
+/* Leitura sobre a vaga ativa: 'ler' recebe a vaga e sua capacidade e
+   devolve >= 0; o resultado só vale se a sequência não mudou no meio. */
+typedef int (*LeituraReplica)(const unsigned char *vaga, uint64_t capacidade, void *ctx);
+
+static int replica_ler(LeitorReplica *l, LeituraReplica ler, void *ctx) {
+    if (!l->base) return -1;
+    for (int tentativa = 0; tentativa < REPLICA_TENTATIVAS; tentativa++) {
+        const CabecalhoReplica *c = (const CabecalhoReplica*) l->base;
+        if (atomic_load_explicit(&c->geracao, memory_order_acquire) == 0) return -1;
+        uint32_t i = atomic_load_explicit(&c->ativa, memory_order_acquire) & 1;
+        uint64_t s1 = atomic_load_explicit(&c->vagas[i].sequencia, memory_order_acquire);
+        if (s1 == 0 || (s1 & 1)) { sched_yield(); continue; }
+        uint64_t deslocamento = atomic_load_explicit(&c->vagas[i].deslocamento, memory_order_relaxed);
+        uint64_t capacidade = atomic_load_explicit(&c->vagas[i].capacidade, memory_order_relaxed);
+        if (!replica_cobrir(l, deslocamento + capacidade)) { sched_yield(); continue; }
+        c = (const CabecalhoReplica*) l->base;
+        int r = ler(l->base + deslocamento, capacidade, ctx);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&c->vagas[i].sequencia, memory_order_relaxed) == s1 && r >= 0) return r;
+        sched_yield();
+    }
+    return -1;
+}
+
+// Cópia validada do cabeçalho da vaga (NULL se os vetores não cabem nela)
+static int replica_imagem(const unsigned char *vaga, uint64_t capacidade, ImagemReplica *im) {
+    if (capacidade < sizeof(ImagemReplica)) return 0;
+    memcpy(im, vaga, sizeof(ImagemReplica));
+    return im->off_turmas + (uint64_t) im->qtd_turmas * sizeof(TurmaReplica) <= capacidade &&
+           im->off_alunos + (uint64_t) im->qtd_alunos * sizeof(AlunoReplica) <= capacidade &&
+           im->off_disciplinas + (uint64_t) im->qtd_disciplinas * sizeof(DisciplinaReplica) <= capacidade &&
+           im->off_indice + (uint64_t) im->qtd_alunos * sizeof(uint32_t) <= capacidade;
+}
+
+typedef struct {
+    const char *matricula;
+    char turma[10];
+    AlunoReplica aluno;
+    DisciplinaReplica disciplinas[MAX_DISCIPLINAS];
+} ConsultaAlunoReplica;
+
+// Busca binária no índice por matrícula; copia o aluno e suas disciplinas
+static int ler_aluno_replica(const unsigned char *vaga, uint64_t capacidade, void *ctx) {
+    ConsultaAlunoReplica *q = (ConsultaAlunoReplica*) ctx;
+    ImagemReplica im;
+    if (!replica_imagem(vaga, capacidade, &im)) return -1;
+    const AlunoReplica *alunos = (const AlunoReplica*) (vaga + im.off_alunos);
+    const uint32_t *indice = (const uint32_t*) (vaga + im.off_indice);
+    uint32_t ini = 0, fim = im.qtd_alunos;
+    while (ini < fim) {
+        uint32_t meio = ini + (fim - ini) / 2, k = indice[meio];
+        if (k >= im.qtd_alunos) return -1;
+        int cmp = strncmp(alunos[k].matricula, q->matricula, sizeof(alunos[k].matricula));
+        if (cmp == 0) {
+            q->aluno = alunos[k];
+            q->aluno.matricula[sizeof(q->aluno.matricula) - 1] = '\0';
+            q->aluno.nome[sizeof(q->aluno.nome) - 1] = '\0';
+            if (q->aluno.qtd_disciplinas > MAX_DISCIPLINAS ||
+                q->aluno.primeira_disciplina + (uint64_t) q->aluno.qtd_disciplinas > im.qtd_disciplinas ||
+                q->aluno.turma >= im.qtd_turmas) return -1;
+            memcpy(q->disciplinas, vaga + im.off_disciplinas + (uint64_t) q->aluno.primeira_disciplina * sizeof(DisciplinaReplica),
+                   q->aluno.qtd_disciplinas * sizeof(DisciplinaReplica));
+            const TurmaReplica *t = (const TurmaReplica*) (vaga + im.off_turmas) + q->aluno.turma;
+            memcpy(q->turma, t->codigo, sizeof(q->turma));
+            q->turma[sizeof(q->turma) - 1] = '\0';
+            return 1;
+        }
+        if (cmp < 0) ini = meio + 1; else fim = meio;
+    }
+    return 0;
+}
+
+/* Boletim a partir da réplica. Retorna 1, 0 (não encontrado) ou -1 (réplica
+   indisponível). */
+int replica_exibir_boletim(LeitorReplica *l, const char *matricula) {
+    ConsultaAlunoReplica q;
+    memset(&q, 0, sizeof(q));
+    q.matricula = matricula;
+    int r = replica_ler(l, ler_aluno_replica, &q);
+    if (r != 1) return r;
+    printf("\n========= BOLETIM KOLPING: %s (%s) =========\n", q.aluno.nome, q.aluno.matricula);
+    printf("Turma: %s | Serie: %d\n", q.turma, q.aluno.serie);
+    for (uint32_t i = 0; i < q.aluno.qtd_disciplinas; i++) {
+        DisciplinaReplica *d = &q.disciplinas[i];
+        printf("- %-15.*s | Media Final: %.2f | Prof: %.*s", (int) sizeof(d->nome), d->nome,
+               nota_para_float(d->media_final), (int) sizeof(d->docente), d->docente[0] ? d->docente : "N/A");
+        if (d->aulas > 0) printf(" | Freq: %.1f%%", d->presencas * 100.0 / d->aulas);
+        printf("\n");
+    }
+    printf("Media Geral: %.2f", nota_para_float(q.aluno.media_geral));
+    if (q.aluno.frequencia >= 0) printf(" | Frequencia: %.1f%%", q.aluno.frequencia / 10.0);
+    printf(" | Situacao: %s\n", q.aluno.aprovado ? "APROVADO" : "REPROVADO");
+    printf("======================================================\n");
+    return 1;
+}
+
+typedef struct {
+    const char *codigo;         // NULL = listar turmas
+    Texto *saida;
+} ConsultaTurmaReplica;
+
+// Renderiza o fechamento de uma turma (ou a lista de turmas) no texto de saída
+static int ler_turma_replica(const unsigned char *vaga, uint64_t capacidade, void *ctx) {
+    ConsultaTurmaReplica *q = (ConsultaTurmaReplica*) ctx;
+    ImagemReplica im;
+    if (!replica_imagem(vaga, capacidade, &im)) return -1;
+    const TurmaReplica *turmas = (const TurmaReplica*) (vaga + im.off_turmas);
+    const AlunoReplica *alunos = (const AlunoReplica*) (vaga + im.off_alunos);
+    const DisciplinaReplica *discs = (const DisciplinaReplica*) (vaga + im.off_disciplinas);
+    Texto *tx = q->saida;
+    texto_limpar(tx);
+    for (uint32_t it = 0; it < im.qtd_turmas; it++) {
+        const TurmaReplica *t = &turmas[it];
+        if (!q->codigo) {
+            texto_printf(tx, "Turma %-10.*s | Serie: %2d | Alunos: %d / %d\n",
+                         (int) sizeof(t->codigo), t->codigo, t->serie, t->qtd_atual, t->limite_vagas);
+            continue;
+        }
+        if (strncmp(t->codigo, q->codigo, sizeof(t->codigo)) != 0) continue;
+        if (t->primeiro_aluno + (uint64_t) t->qtd_alunos > im.qtd_alunos) return -1;
+        int aprovados = 0;
+        texto_printf(tx, "\n##############################################################\n");
+        texto_printf(tx, "##    FECHAMENTO DE NOTAS — TURMA %-10.*s (REPLICA)   ##\n", (int) sizeof(t->codigo), t->codigo);
+        texto_printf(tx, "##    Serie: %d | Alunos: %d / %d vagas                  ##\n",
+                     t->serie, t->qtd_atual, t->limite_vagas);
+        texto_printf(tx, "##############################################################\n");
+        for (uint32_t k = 0; k < t->qtd_alunos; k++) {
+            const AlunoReplica *a = &alunos[t->primeiro_aluno + k];
+            if (a->primeira_disciplina + (uint64_t) a->qtd_disciplinas > im.qtd_disciplinas) return -1;
+            aprovados += a->aprovado ? 1 : 0;
+            texto_printf(tx, "\n>> %-20.*s | Mat: %-12.*s | Media: %5.2f | [%s]",
+                         (int) sizeof(a->nome), a->nome, (int) sizeof(a->matricula), a->matricula,
+                         nota_para_float(a->media_geral), a->aprovado ? "APROVADO " : "REPROVADO");
+            if (a->frequencia >= 0)
+                texto_printf(tx, " Freq: %.1f%%%s", a->frequencia / 10.0,
+                             a->frequencia < FREQUENCIA_MINIMA ? " (< 75%)" : "");
+            texto_printf(tx, "\n");
+            for (uint32_t j = 0; j < a->qtd_disciplinas; j++) {
+                const DisciplinaReplica *d = &discs[a->primeira_disciplina + j];
+                texto_printf(tx, "   %-15.*s | ", (int) sizeof(d->nome), d->nome);
+                for (int u = 0; u < 4; u++) texto_printf(tx, "U%d:%.1f ", u + 1, nota_para_float(d->media_unidade[u]));
+                if (d->recuperacao) texto_printf(tx, "Rec:%.1f ", nota_para_float(d->recuperacao));
+                texto_printf(tx, "| Anual: %.2f", nota_para_float(d->media_final));
+                if (d->media_final < t->aprovacao) texto_printf(tx, " [!]");
+                if (d->aulas) texto_printf(tx, " | Faltas: %d/%d", d->aulas - d->presencas, d->aulas);
+                texto_printf(tx, "\n");
+            }
+            texto_printf(tx, "   ----------------------------------------------------------\n");
+        }
+        int total = (int) t->qtd_alunos;
+        texto_printf(tx, "\n##############################################################\n");
+        texto_printf(tx, "##  Aprovados: %d | Reprovados: %d | Total: %d             ##\n",
+                     aprovados, total - aprovados, total);
+        if (total > 0)
+            texto_printf(tx, "##  Taxa de aprovacao: %.1f%%                              ##\n",
+                         100.0f * aprovados / total);
+        texto_printf(tx, "##############################################################\n\n");
+        return 1;
+    }
+    return q->codigo ? 0 : 1;
+}
+
+/* Relatório de fechamento de uma turma (ou, com codigo NULL, a lista de
+   turmas) a partir da réplica. Retorna 1, 0 (turma inexistente) ou -1. */
+int replica_exibir_turmas(LeitorReplica *l, const char *codigo) {
+    Texto tx = {0};
+    ConsultaTurmaReplica q = {codigo, &tx};
+    int r = replica_ler(l, ler_turma_replica, &q);
+    if (r == 1 && tx.dados) fputs(tx.dados, stdout);
+    texto_liberar(&tx);
+    return r;
+}
+
+static int ler_estado_replica(const unsigned char *vaga, uint64_t capacidade, void *ctx) {
+    return replica_imagem(vaga, capacidade, (ImagemReplica*) ctx) ? 1 : -1;
+}
+
+void replica_exibir_estado(LeitorReplica *l) {
+    ImagemReplica im;
+    if (replica_ler(l, ler_estado_replica, &im) != 1) {
+        printf("[INFO] Replica ainda sem publicacao.\n");
+        return;
+    }
+    const CabecalhoReplica *c = (const CabecalhoReplica*) l->base;
+    char data[20];
+    time_t publicado = (time_t) im.publicado_em;
+    strftime(data, sizeof(data), "%d/%m/%Y %H:%M:%S", localtime(&publicado));
+    im.campus[sizeof(im.campus) - 1] = '\0';
+    printf("\n--- REPLICA ---\n");
+    printf("Campus: %s | Publicacao #%llu em %s\n", im.campus,
+           (unsigned long long) atomic_load(&c->geracao), data);
+    printf("Turmas: %u | Alunos: %u | Disciplinas: %u | Regiao: %zu bytes\n",
+           im.qtd_turmas, im.qtd_alunos, im.qtd_disciplinas, l->tamanho);
+}
+
+#else /* _WIN32: sem shm_open; a réplica fica indisponível */
+
+int iniciar_publicacao(PublicadorReplica *p, const char *nome) {
+    (void) nome;
+    memset(p, 0, sizeof(PublicadorReplica));
+    return 0;
+}
+int publicar_replica(PublicadorReplica *p, Turma *lista, const char *campus, int forcar) {
+    (void) p; (void) lista; (void) campus; (void) forcar;
+    return -1;
+}
+void encerrar_publicacao(PublicadorReplica *p) { (void) p; }
+int abrir_replica(LeitorReplica *l, const char *nome) {
+    (void) nome;
+    memset(l, 0, sizeof(LeitorReplica));
+    return 0;
+}
+void fechar_replica(LeitorReplica *l) { (void) l; }
+int replica_exibir_boletim(LeitorReplica *l, const char *matricula) { (void) l; (void) matricula; return -1; }
+int replica_exibir_turmas(LeitorReplica *l, const char *codigo) { (void) l; (void) codigo; return -1; }
+void replica_exibir_estado(LeitorReplica *l) { (void) l; printf("[INFO] Replica indisponivel nesta plataforma.\n"); }
+
+#endif